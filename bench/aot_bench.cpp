@@ -0,0 +1,46 @@
+#include "bench_util.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Paths are set by bench/CMakeLists.txt
+#ifndef LOX_INTERPRETER
+#define LOX_INTERPRETER "lox"
+#endif
+#ifndef LOX_AOT_DIR
+#define LOX_AOT_DIR "."
+#endif
+#ifndef LOX_SCRIPT_DIR
+#define LOX_SCRIPT_DIR "aot"
+#endif
+
+namespace {
+
+// Best time of a whole process, output thrown away
+double runTime(const std::string& command) {
+    std::string quiet = command + " > /dev/null";
+    return Lox::Bench::timeBest(3, [&]() {
+        if (std::system(quiet.c_str()) != 0) std::exit(2);
+    });
+}
+
+} // anonymous namespace
+
+// Scripts from bench/aot/ run by lox, with and without its JIT, next to
+// the executables loxc made of them. Every time includes starting the
+// process; speedups are against the plain tree-walker.
+int main() {
+    const char* scripts[] = {"fib", "loop", "closures", "strings"};
+
+    std::printf("%-10s %12s %23s %23s\n", "", "interpreted", "with --jit", "transpiled");
+    for (auto* script : scripts) {
+        std::string path = std::string{LOX_SCRIPT_DIR} + "/" + script + ".lox";
+        double interpreted = runTime(std::string{LOX_INTERPRETER} + " --jit=off " + path);
+        double jit = runTime(std::string{LOX_INTERPRETER} + " --jit=on " + path);
+        double transpiled = runTime(std::string{LOX_AOT_DIR} + "/aot_" + script);
+        std::printf("%-10s %9.3f ms %9.3f ms (%8.2fx) %9.3f ms (%8.2fx)\n", script, interpreted * 1000.0,
+            jit * 1000.0, interpreted / jit, transpiled * 1000.0, interpreted / transpiled);
+    }
+    return 0;
+}
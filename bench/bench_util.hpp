@@ -0,0 +1,60 @@
+#ifndef BENCH_UTIL_HPP
+#define BENCH_UTIL_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace Lox {
+namespace Bench {
+
+// Best-of-N wall clock time of fn() in seconds
+template<typename Fn>
+double timeBest(int runs, Fn&& fn) {
+    double best = 1e300;
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto stop = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(stop - start).count();
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+inline std::string readFile(const std::string& path) {
+    std::ifstream file(path);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// A machine-generated looking Lox script of roughly the requested size, with
+// the usual mix of declarations, comments, strings and arithmetic.
+inline std::string generateSource(size_t bytes) {
+    std::string source{};
+    source.reserve(bytes + 256);
+    for (size_t i = 0; source.size() < bytes; i++) {
+        auto n = std::to_string(i);
+        source += "// generated helper number " + n + ", the comment is long enough to matter\n";
+        source += "fun helper_" + n + "(alpha, beta) {\n";
+        source += "\n        \t\n    var total = alpha * " + n + ".25 + beta / 3;\n";
+        source += "    if (total >= 100 and alpha != beta) {\n";
+        source += "        print \"helper " + n + " produced a large value,\n            more than a hundred\";\n";
+        source += "    }\n";
+        source += "    while (total > 1) { total = total - 1; }\n";
+        source += "    return total;\n";
+        source += "}\n";
+        source += "var result_" + n + " = helper_" + n + "(" + n + ", 2);\n";
+    }
+    return source;
+}
+
+inline void report(const char* name, size_t bytes, double seconds) {
+    std::printf("%-28s %10.2f MB/s  (%8.3f ms)\n", name, bytes / seconds / (1024.0 * 1024.0), seconds * 1000.0);
+}
+
+} // Bench namespace
+} // Lox namespace
+
+#endif
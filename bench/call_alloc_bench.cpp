@@ -0,0 +1,88 @@
+#include "interpreter.hpp"
+#include "parser.hpp"
+#include "resolver.hpp"
+#include "scanner.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+// Counts every malloc in the process, including the ones operator new and
+// the exception runtime make on the interpreter's behalf
+extern "C" void* __libc_malloc(size_t);
+static size_t allocations = 0;
+
+extern "C" void* malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+namespace {
+
+class Sample {
+public:
+    const char* name;
+    std::string text;
+    // Calls or loop iterations the script makes
+    size_t operations;
+    // Allocations each of them still needs
+    double budget;
+};
+
+// Allocations made while running `text`; scanning, parsing and resolving
+// are not counted
+size_t runAllocations(const std::string& text) {
+    Lox::Scanner scanner{std::make_shared<const Lox::SourceBuffer>(text)};
+    Lox::Parser parser{scanner};
+    auto program = parser.parse();
+
+    Lox::Interpreter interpreter{};
+    Lox::Resolver resolver{&interpreter};
+    resolver.resolve(*program);
+    if (Lox::Lox::hadError) std::exit(2);
+
+    size_t before = allocations;
+    interpreter.interpret(*program);
+    return allocations - before;
+}
+
+} // anonymous namespace
+
+// Heap allocations per call and per loop iteration. Frames live on the
+// interpreter's value stack and returns are not exceptions, so calls and
+// iterations whose locals are never captured should not allocate at all.
+// The exit status is 1 if a sample goes over its budget.
+int main() {
+    Sample samples[] = {
+        // fib(20) makes 21891 calls
+        {"recursive fib(20)",
+            "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+            "fib(20);\n",
+            21891, 0},
+        {"recursive sum, locals",
+            "fun sum(n) { var half = n / 2; var rest = 0; if (n > 0) rest = sum(n - 1); return n + rest; }\n"
+            "for (var i = 0; i < 100; i = i + 1) sum(200);\n",
+            100 * 201, 0},
+        {"loop with block locals",
+            "{ var i = 0; while (i < 100000) { var j = i * 2; { var k = j + 1; } i = i + 1; } }\n",
+            100000, 0},
+        // The counter's variable is captured, the call itself is not
+        {"closure calls",
+            "fun make() { var n = 0; fun inc() { n = n + 1; return n; } return inc; }\n"
+            "var counter = make();\n"
+            "for (var i = 0; i < 20000; i = i + 1) counter();\n",
+            20000, 0},
+    };
+
+    int status = 0;
+    for (auto& sample : samples) {
+        size_t count = runAllocations(sample.text);
+        double each = double(count) / sample.operations;
+        std::printf("%-26s %8zu allocs  %6.3f per operation (budget %.0f)\n",
+            sample.name, count, each, sample.budget);
+        if (each > sample.budget + 0.01) status = 1;
+    }
+
+    return status;
+}
@@ -0,0 +1,61 @@
+#include "bench_util.hpp"
+#include "interpreter.hpp"
+#include "parser.hpp"
+#include "resolver.hpp"
+#include "scanner.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Appends `pieces` ten character pieces to a global with `s = s + piece`,
+// then reads the result once, the way print would
+void build(size_t pieces) {
+    std::string text =
+        "var s = \"\";\n"
+        "var i = 0;\n"
+        "while (i < " + std::to_string(pieces) + ") { s = s + \"0123456789\"; i = i + 1; }\n";
+
+    Lox::Scanner scanner{std::make_shared<const Lox::SourceBuffer>(text)};
+    Lox::Parser parser{scanner};
+    auto program = parser.parse();
+    Lox::Interpreter interpreter{};
+    Lox::Resolver resolver{&interpreter};
+    resolver.resolve(*program);
+    if (Lox::Lox::hadError) std::exit(2);
+
+    auto start = std::chrono::steady_clock::now();
+    interpreter.interpret(*program);
+    double loop = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t length = interpreter.globals.intern("s")->value.asString().size();
+    double read = secondsSince(start);
+
+    if (length != pieces * 10) std::exit(3);
+    std::printf("%8.2f MB in %8zu pieces   loop %8.3f s   first read %7.3f s   %7.1f ns/piece\n",
+        length / (1024.0 * 1024.0), pieces, loop, read, (loop + read) * 1e9 / pieces);
+}
+
+} // anonymous namespace
+
+// Building a large string from small pieces in a Lox loop. Each size is ten
+// times the last, so linear work shows up as a constant time per piece.
+//
+// usage: concat_bench [MAX_MEGABYTES]
+int main(int argc, char** argv) {
+    double megabytes = argc > 1 ? std::atof(argv[1]) : 10;
+    size_t maximum = static_cast<size_t>(megabytes * 1024 * 1024 / 10);
+    for (size_t pieces = maximum; pieces >= 1000; pieces /= 10) {
+        build(pieces);
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "bench_util.hpp"
+#include "closure_engine.hpp"
+#include "interpreter.hpp"
+#include "parser.hpp"
+#include "resolver.hpp"
+#include "scanner.hpp"
+#include "vm.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace {
+
+class Sample {
+public:
+    const char* name;
+    std::string text;
+};
+
+// Best time to run `text` on one of the engines; scanning, parsing and
+// resolving are not counted, compiling or lowering the tree is.
+double runTime(const std::string& text, Lox::Engine engine) {
+    return Lox::Bench::timeBest(5, [&]() {
+        Lox::Scanner scanner{std::make_shared<const Lox::SourceBuffer>(text)};
+        Lox::Parser parser{scanner};
+        auto program = parser.parse();
+        Lox::Interpreter interpreter{};
+        Lox::Resolver resolver{&interpreter};
+        resolver.resolve(*program);
+        if (Lox::Lox::hadError) std::exit(2);
+        if (engine == Lox::Engine::VM) {
+            Lox::VM machine{&interpreter};
+            machine.interpret(*program);
+        } else if (engine == Lox::Engine::CLOSURE) {
+            Lox::ClosureEngine closures{&interpreter};
+            closures.interpret(*program);
+        } else {
+            interpreter.interpret(*program);
+        }
+    });
+}
+
+} // anonymous namespace
+
+// The tree-walker next to the bytecode VM and the closure engine on calls,
+// loops and strings. The JIT stays off, jit_bench measures it.
+int main() {
+    Lox::Lox::jit.enabled = false;
+    Sample samples[] = {
+        {"recursive fib(25)",
+            "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+            "fib(25);\n"},
+        {"global loop",
+            "var i = 0; while (i < 1000000) i = i + 1;\n"},
+        {"local loop",
+            "{ var sum = 0; for (var i = 0; i < 1000000; i = i + 1) {\n"
+            "    sum = sum + i * 3; if (sum > 1000000) sum = sum - 1000000; } }\n"},
+        {"closure counter",
+            "fun counter() { var n = 0; fun next() { n = n + 1; return n; } return next; }\n"
+            "var next = counter(); var i = 0; while (i < 300000) i = next();\n"},
+        {"string building",
+            "{ var s = \"\"; for (var i = 0; i < 100000; i = i + 1) {\n"
+            "    s = s + \"x\"; if (s == \"never\") s = \"\"; } }\n"},
+    };
+
+    std::printf("%-22s %10s %19s %19s\n", "", "tree", "vm", "closure");
+    for (auto& sample : samples) {
+        double tree = runTime(sample.text, Lox::Engine::TREE);
+        double vm = runTime(sample.text, Lox::Engine::VM);
+        double closure = runTime(sample.text, Lox::Engine::CLOSURE);
+        std::printf("%-22s %7.3f ms %7.3f ms (%5.2fx) %7.3f ms (%5.2fx)\n", sample.name, tree * 1000.0,
+            vm * 1000.0, tree / vm, closure * 1000.0, tree / closure);
+    }
+    return 0;
+}
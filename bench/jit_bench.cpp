@@ -0,0 +1,64 @@
+#include "bench_util.hpp"
+#include "interpreter.hpp"
+#include "parser.hpp"
+#include "resolver.hpp"
+#include "scanner.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace {
+
+class Sample {
+public:
+    const char* name;
+    std::string text;
+};
+
+// Best time for the tree-walker to run `text`, with the JIT on or off.
+// Every run parses afresh, so each one warms up and compiles again.
+double runTime(const std::string& text, bool jit) {
+    Lox::Lox::jit.enabled = jit;
+    return Lox::Bench::timeBest(5, [&]() {
+        Lox::Scanner scanner{std::make_shared<const Lox::SourceBuffer>(text)};
+        Lox::Parser parser{scanner};
+        auto program = parser.parse();
+        Lox::Interpreter interpreter{};
+        Lox::Resolver resolver{&interpreter};
+        resolver.resolve(*program);
+        if (Lox::Lox::hadError) std::exit(2);
+        interpreter.interpret(*program);
+    });
+}
+
+} // anonymous namespace
+
+// Numeric functions with and without the baseline JIT, and one it cannot
+// compile, to show what the call counting costs
+int main() {
+    Sample samples[] = {
+        {"recursive fib(25)",
+            "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+            "fib(25);\n"},
+        {"loop in a function",
+            "fun sum(n) { var s = 0; var i = 0; while (i < n) { s = s + i * 3;\n"
+            "    if (s > 1000000) s = s - 1000000; i = i + 1; } return s; }\n"
+            "for (var k = 0; k < 100; k = k + 1) sum(10000);\n"},
+        {"small hot function",
+            "fun lerp(a, b, t) { return a + (b - a) * t; }\n"
+            "var x = 0; for (var i = 0; i < 300000; i = i + 1) x = lerp(x, i, 0.5);\n"},
+        {"not compiled",
+            "fun greet(s) { return s + \"!\"; }\n"
+            "for (var i = 0; i < 100000; i = i + 1) greet(\"hi\");\n"},
+    };
+
+    std::printf("%-22s %10s %19s\n", "", "jit off", "jit on");
+    for (auto& sample : samples) {
+        double off = runTime(sample.text, false);
+        double on = runTime(sample.text, true);
+        std::printf("%-22s %7.3f ms %7.3f ms (%5.2fx)\n", sample.name, off * 1000.0, on * 1000.0, off / on);
+    }
+    return 0;
+}
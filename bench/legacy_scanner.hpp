@@ -0,0 +1,150 @@
+#ifndef LEGACY_SCANNER_HPP
+#define LEGACY_SCANNER_HPP
+
+#include "token.hpp"
+#include "token_type.hpp"
+#include "lox.hpp"
+#include "value.hpp"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace Lox {
+
+// The original switch-based scanner, kept only as a benchmark baseline. Every
+// token owns a copy of its lexeme and literals are decoded eagerly.
+class LegacyScanner {
+public:
+    explicit LegacyScanner(const std::string& source) : _source{source}
+    {}
+
+    std::list<Token> scanTokens() {
+        while (!isAtEnd()) {
+            _start = _current;
+            scanToken();
+        }
+        _tokens.push_back(Token{TokenType::END, "", Value{}, _line});
+        return _tokens;
+    }
+
+private:
+    bool isAtEnd() {return _current >= _source.length();}
+    char advance() {return _source[_current++];}
+    char peek() {return isAtEnd() ? '\0' : _source[_current];}
+    char peekNext() {return _current + 1 >= _source.length() ? '\0' : _source[_current+1];}
+    bool isDigit(char c) {return c >= '0' && c <= '9';}
+    bool isAlpha(char c) {return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';}
+    bool isAlphaNumeric(char c) {return isAlpha(c) || isDigit(c);}
+
+    void addToken(const TokenType& type) {addToken(type, Value{});}
+    void addToken(const TokenType& type, Value literal) {
+        std::string text = _source.substr(_start, _current-_start);
+        _tokens.push_back(Token{type,text,literal,_line});
+    }
+
+    bool match(char expected) {
+        if (isAtEnd() || _source[_current] != expected) return false;
+        _current++;
+        return true;
+    }
+
+    void number() {
+        while(isDigit(peek())) advance();
+        if (peek() == '.' && isDigit(peekNext())) {
+            advance();
+            while (isDigit(peek())) advance();
+        }
+        addToken(TokenType::NUMBER,Value{std::stod(_source.substr(_start,_current-_start))});
+    }
+
+    void identifier() {
+        while(isAlphaNumeric(peek())) advance();
+        std::string text = _source.substr(_start,_current-_start);
+        if (keywords().find(text) != keywords().end()) {
+            addToken(keywords().at(text));
+        } else {
+            addToken(TokenType::IDENTIFIER);
+        }
+    }
+
+    void string() {
+        while (peek() != '"' && !isAtEnd()) {
+            if (peek() == '\n') _line++;
+            advance();
+        }
+        if (isAtEnd()) {
+            Lox::error(_line, "Unterminated string.");
+            return;
+        }
+        advance();
+        std::string value = _source.substr(_start + 1, _current -_start - 2);
+        addToken(TokenType::STRING, Value{value});
+    }
+
+    void scanToken() {
+        char c = advance();
+        switch (c)
+        {
+        case '(': addToken(TokenType::LEFT_PAREN);break;
+        case ')': addToken(TokenType::RIGHT_PAREN); break; 
+        case '{': addToken(TokenType::LEFT_BRACE); break; 
+        case '}': addToken(TokenType::RIGHT_BRACE); break; 
+        case ',': addToken(TokenType::COMMA); break;
+        case '.': addToken(TokenType::DOT); break;
+        case '-': addToken(TokenType::MINUS); break; 
+        case '+': addToken(TokenType::PLUS); break;
+        case ';': addToken(TokenType::SEMICOLON); break; 
+        case '*': addToken(TokenType::STAR); break;
+        case '!': addToken(match('=') ? TokenType::BANG_EQUAL : TokenType::BANG); break;
+        case '=': addToken(match('=') ? TokenType::EQUAL_EQUAL : TokenType::EQUAL); break;
+        case '<': addToken(match('=') ? TokenType::LESS_EQUAL : TokenType::LESS); break;
+        case '>': addToken(match('=') ? TokenType::GREATER_EQUAL : TokenType::GREATER); break;
+        case '/': {
+            if (match('/')) {
+                while(peek() != '\n' && !isAtEnd()) advance();
+            } else {
+                addToken(TokenType::SLASH);
+            }
+            break;
+        }
+        case ' ': 
+        case '\r':
+        case '\t':
+            break;
+        case '\n': _line++; break;
+        case '"': string(); break;
+        default:
+            if (isDigit(c)) {
+                number();
+            } else if (isAlpha(c)) {
+                identifier();
+            } else {
+                Lox::error(_line,"Unexpected character.");
+            }
+            break;
+        }
+    }
+
+    static const std::unordered_map<std::string, TokenType>& keywords() {
+        static const std::unordered_map<std::string, TokenType> table{
+            {"and", TokenType::AND}, {"class", TokenType::CLASS}, {"else", TokenType::ELSE},
+            {"false", TokenType::FALSE}, {"for", TokenType::FOR}, {"fun", TokenType::FUN},
+            {"if", TokenType::IF}, {"nil", TokenType::NIL}, {"or", TokenType::OR},
+            {"print", TokenType::PRINT}, {"return", TokenType::RETURN}, {"super", TokenType::SUPER},
+            {"this", TokenType::THIS}, {"true", TokenType::TRUE}, {"var", TokenType::VAR},
+            {"while", TokenType::WHILE}
+        };
+        return table;
+    }
+
+    std::string _source;
+    std::list<Token> _tokens;
+    int _start = 0;
+    int _current = 0;
+    int _line = 1;
+};
+
+} // Lox namespace
+
+#endif
@@ -0,0 +1,58 @@
+#include "bench_util.hpp"
+#include "interpreter.hpp"
+#include "parser.hpp"
+#include "resolver.hpp"
+#include "scanner.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace {
+
+class Sample {
+public:
+    const char* name;
+    std::string text;
+};
+
+// Best time to run `text`; scanning, parsing and resolving are not counted.
+// Everything the script prints goes to a string stream.
+double runTime(const std::string& text) {
+    return Lox::Bench::timeBest(5, [&]() {
+        Lox::Scanner scanner{std::make_shared<const Lox::SourceBuffer>(text)};
+        Lox::Parser parser{scanner};
+        auto program = parser.parse();
+        Lox::Interpreter interpreter{};
+        Lox::Resolver resolver{&interpreter};
+        resolver.resolve(*program);
+        if (Lox::Lox::hadError) std::exit(2);
+        interpreter.interpret(*program);
+    });
+}
+
+} // anonymous namespace
+
+// Loops whose arithmetic is counters and indices, the case integers are for,
+// next to the same loops on numbers with a fraction.
+int main() {
+    Sample samples[] = {
+        {"global counter",
+            "var i = 0; while (i < 3000000) i = i + 1;\n"},
+        {"local counters",
+            "{ var sum = 0; for (var i = 0; i < 1000000; i = i + 1) {\n"
+            "    sum = sum + i * 3; if (sum > 1000000) sum = sum - 1000000; } }\n"},
+        {"local fractions",
+            "{ var sum = 0.5; for (var i = 0.5; i < 1000000.5; i = i + 1.5) {\n"
+            "    sum = sum + i * 3.5; if (sum > 1000000.5) sum = sum - 1000000.5; } }\n"},
+        {"recursive fib(22)",
+            "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+            "fib(22);\n"},
+    };
+
+    for (auto& sample : samples) {
+        std::printf("%-22s %8.3f ms\n", sample.name, runTime(sample.text) * 1000.0);
+    }
+    return 0;
+}
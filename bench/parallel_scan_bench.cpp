@@ -0,0 +1,100 @@
+#include "bench_util.hpp"
+#include "parallel_scanner.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+#include "streaming_scanner.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+bool sameTokens(const std::vector<Lox::CompactToken>& a, const std::vector<Lox::CompactToken>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].type != b[i].type || a[i].offset != b[i].offset || 
+            a[i].length != b[i].length || a[i].line != b[i].line) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Everything reported while parsing from `source`, in the order it came out
+std::string parseErrors(Lox::TokenSource& source) {
+    std::ostringstream errors{};
+    auto* saved = std::cerr.rdbuf(errors.rdbuf());
+    Lox::Parser{source}.parse();
+    std::cerr.rdbuf(saved);
+    return errors.str();
+}
+
+// Scan errors have to come out interleaved with parse errors in source order,
+// whichever way the script is scanned
+bool sameErrorOrder() {
+    using namespace Lox;
+    const std::string text = "print 1;\n1 = 2;\nprint @;\nvar x = 1 +;\nprint #;\n";
+    auto source = std::make_shared<const SourceBuffer>(text);
+
+    Scanner serial{source};
+    auto expected = parseErrors(serial);
+    ParallelScanner parallel{source, 4, 8};
+    if (parseErrors(parallel) != expected) return false;
+    // One window for the whole script, then windows that cut tokens
+    for (size_t window : {StreamingScanner::DEFAULT_WINDOW_SIZE, size_t{5}}) {
+        std::istringstream input{text};
+        StreamingScanner streaming{input, window};
+        if (parseErrors(streaming) != expected) return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// Parallel tokenization throughput for 1..N threads, checked against the
+// serial scanner.
+//
+// usage: parallel_scan_bench [script.lox] [max threads]
+int main(int argc, char** argv) {
+    using namespace Lox;
+
+    std::string text = argc > 1 ? Bench::readFile(argv[1]) : Bench::generateSource(32 * 1024 * 1024);
+    unsigned maxThreads = argc > 2 ? std::stoul(argv[2]) : std::max(4u, std::thread::hardware_concurrency());
+    auto source = std::make_shared<const SourceBuffer>(text);
+    const int runs = 5;
+
+    // Tiny chunks put cuts next to strings and comments; the stitched stream
+    // still has to match
+    auto serial = Scanner{source}.scanCompactTokens();
+    for (size_t chunk : {64, 4096}) {
+        if (!sameTokens(serial, ParallelScanner{source, 4, chunk}.scanCompactTokens())) {
+            std::fprintf(stderr, "parallel scan with %zu byte chunks differs from the serial scan\n", chunk);
+            return 1;
+        }
+    }
+    if (!sameErrorOrder()) {
+        std::fprintf(stderr, "scan errors come out in a different order than with the serial scan\n");
+        return 1;
+    }
+    std::printf("%zu bytes, %zu tokens, %u hardware threads\n", text.size(), serial.size(), std::thread::hardware_concurrency());
+
+    size_t sink = 0;
+    double base = Bench::timeBest(runs, [&]() { sink += Scanner{source}.scanCompactTokens().size(); });
+    Bench::report("serial", text.size(), base);
+
+    for (unsigned threads = 2; threads <= maxThreads; threads *= 2) {
+        double seconds = Bench::timeBest(runs, [&]() {
+            sink += ParallelScanner{source, threads}.scanCompactTokens().size();
+        });
+        std::string name = std::to_string(threads) + " threads";
+        Bench::report(name.c_str(), text.size(), seconds);
+        std::printf("%-28s %10.2fx\n", "", base / seconds);
+    }
+
+    return sink == 0;
+}
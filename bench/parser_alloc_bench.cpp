@@ -0,0 +1,96 @@
+#include "bench_util.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+// Every heap allocation in the process goes through here
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+size_t countTokens(const std::string& text) {
+    Lox::Scanner scanner{std::make_shared<const Lox::SourceBuffer>(text)};
+    size_t count = 0;
+    while (scanner.next().type != Lox::TokenType::END) count++;
+    return count;
+}
+
+// Allocations made while parsing `text`, not counting the source buffer
+size_t parseAllocations(const std::string& text) {
+    auto source = std::make_shared<const Lox::SourceBuffer>(text);
+    Lox::Scanner scanner{source};
+    Lox::Parser parser{scanner};
+
+    size_t before = allocations;
+    auto statements = parser.parse();
+    return allocations - before;
+}
+
+class Sample {
+public:
+    const char* name;
+    std::string text;
+    // Allocations the AST itself needs per statement
+    int astAllocations;
+};
+
+} // anonymous namespace
+
+// Heap allocations made while parsing, per statement and per token. Nodes and
+// child lists come out of the program's arena, so the only allocations the AST
+// needs are for interned names and literals, one per distinct text.
+// Anything above that is the cost of consuming tokens, which should be nothing;
+// the exit status is 1 if any sample goes over.
+int main() {
+    using namespace Lox;
+    const int statements = 20000;
+
+    Sample samples[] = {
+        // name
+        {"print name;", "", 1},
+        // name; the string is the same literal every time, interned once
+        {"print name + \"string\";", "", 1},
+        // name
+        {"var name = (1 + 2) * 3;", "", 1},
+        // Short names only
+        {"if (a < 1) { print b; }", "", 0}
+    };
+    for (int i = 0; i < statements; i++) {
+        auto n = std::to_string(i);
+        samples[0].text += "print a_rather_long_variable_name_" + n + ";\n";
+        samples[1].text += "print a_rather_long_variable_name_" + n + " + \"a string literal that is long\";\n";
+        samples[2].text += "var a_rather_long_variable_name_" + n + " = (1 + 2) * 3;\n";
+        samples[3].text += "if (a < 1) { print b; }\n";
+    }
+
+    int status = 0;
+    for (auto& sample : samples) {
+        size_t tokens = countTokens(sample.text);
+        size_t count = parseAllocations(sample.text);
+        std::printf("%-26s %6.2f allocs/statement (AST needs %d)  %6.3f allocs/token\n",
+            sample.name, double(count) / statements, sample.astAllocations, double(count) / tokens);
+        // Leave a little room for arena blocks and scratch vectors growing
+        if (count > size_t(sample.astAllocations) * statements + 256) status = 1;
+    }
+
+    return status;
+}
@@ -0,0 +1,57 @@
+#include "bench_util.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace {
+
+// Mostly expressions: arithmetic and comparisons of every precedence level,
+// logical operators, calls and a few deeply nested groupings.
+std::string expressionSource(size_t bytes) {
+    std::string source{};
+    source.reserve(bytes + 256);
+    for (size_t i = 0; source.size() < bytes; i++) {
+        auto n = std::to_string(i);
+        source += "var e" + n + " = a * " + n + " + b / 2 - -c * (d + 1) * 3;\n";
+        source += "print e" + n + " >= 10 and e" + n + " != nil or !flag == false;\n";
+        source += "x = y = f(g(1, 2), \"" + n + "\", h(a + b) * 2);\n";
+        source += "print ((((1 + 2) * (3 - 4)) / ((5 + 6) * (7 - 8))) < 9);\n";
+        source += "print 1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11 + 12 + 13 + 14 + 15 + 16;\n";
+    }
+    return source;
+}
+
+} // anonymous namespace
+
+// Scan + parse throughput on an expression heavy script and on the generic
+// generated one.
+//
+// usage: parser_bench [script.lox]
+int main(int argc, char** argv) {
+    using namespace Lox;
+    const int runs = 5;
+
+    auto parse = [&](const char* name, const std::string& text) {
+        auto source = std::make_shared<const SourceBuffer>(text);
+        size_t statements = 0;
+        double seconds = Bench::timeBest(runs, [&]() {
+            Scanner scanner{source};
+            Parser parser{scanner};
+            statements = parser.parse()->statements.size();
+        });
+        Bench::report(name, text.size(), seconds);
+        return statements;
+    };
+
+    if (argc > 1) {
+        parse(argv[1], Bench::readFile(argv[1]));
+        return 0;
+    }
+    parse("expressions", expressionSource(16 * 1024 * 1024));
+    parse("generated", Bench::generateSource(16 * 1024 * 1024));
+
+    return Lox::Lox::hadError ? 1 : 0;
+}
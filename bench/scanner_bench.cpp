@@ -0,0 +1,69 @@
+#include "bench_util.hpp"
+#include "legacy_scanner.hpp"
+#include "scanner.hpp"
+#include "scan_kernels.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// Scanner throughput in MB/s: the original switch-based scanner against the
+// table-driven core, both materializing Tokens and in compact mode with each
+// set of run-skipping kernels the CPU supports.
+//
+// usage: scanner_bench [script.lox]
+int main(int argc, char** argv) {
+    using namespace Lox;
+
+    std::string source = argc > 1 ? Bench::readFile(argv[1]) : Bench::generateSource(8 * 1024 * 1024);
+    auto buffer = std::make_shared<const SourceBuffer>(source);
+    const int runs = 5;
+
+    // Both scanners must agree before their speed means anything
+    auto legacy = LegacyScanner{source}.scanTokens();
+    setScanKernels(KernelSet::SCALAR);
+    auto compact = Scanner{buffer}.scanCompactTokens();
+    if (legacy.size() != compact.size()) {
+        std::fprintf(stderr, "token count mismatch: %zu vs %zu\n", legacy.size(), compact.size());
+        return 1;
+    }
+    auto it = compact.begin();
+    for (auto& token : legacy) {
+        if (token.type != it->type || token.line != it->line || token.lexeme != it->lexeme(buffer->view())) {
+            std::fprintf(stderr, "token mismatch at line %d\n", token.line);
+            return 1;
+        }
+        ++it;
+    }
+    std::printf("%zu bytes, %zu tokens\n", source.size(), compact.size());
+
+    size_t sink = 0;
+    Bench::report("legacy scanTokens", source.size(), Bench::timeBest(runs, [&]() {
+        sink += LegacyScanner{source}.scanTokens().size();
+    }));
+    Bench::report("table scanTokens", source.size(), Bench::timeBest(runs, [&]() {
+        sink += Scanner{buffer}.scanTokens().size();
+    }));
+    for (auto set : {KernelSet::SCALAR, KernelSet::SSE2, KernelSet::AVX2}) {
+        if (!kernelSetSupported(set)) continue;
+        setScanKernels(set);
+
+        // Every kernel set has to produce exactly the scalar token stream
+        auto tokens = Scanner{buffer}.scanCompactTokens();
+        for (size_t i = 0; i < tokens.size(); i++) {
+            auto& a = tokens[i];
+            auto& b = compact[i];
+            if (a.type != b.type || a.offset != b.offset || a.length != b.length || a.line != b.line) {
+                std::fprintf(stderr, "%s kernels disagree at token %zu\n", scanKernels().name, i);
+                return 1;
+            }
+        }
+
+        std::string name = std::string{"compact ("} + scanKernels().name + ")";
+        Bench::report(name.c_str(), source.size(), Bench::timeBest(runs, [&]() {
+            sink += Scanner{buffer}.scanCompactTokens().size();
+        }));
+    }
+
+    return sink == 0;
+}
@@ -0,0 +1,79 @@
+#include "bench_util.hpp"
+#include "expr.hpp"
+#include "token.hpp"
+#include "value.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Keeps the compiler from dropping the work being timed
+volatile double sink = 0;
+
+void report(const char* name, size_t operations, double seconds) {
+    std::printf("%-28s %8.2f ns/op\n", name, seconds * 1e9 / operations);
+}
+
+} // anonymous namespace
+
+// Cost of Value::operator+ and Value::operator== on numbers, integers,
+// strings and mixed operands, and the size of a Value and of the things holding one.
+int main() {
+    using namespace Lox;
+    const int runs = 5;
+    const size_t count = 1024;
+    const size_t rounds = 20000;
+
+    std::printf("sizeof(Value)   %zu\n", sizeof(Value));
+    std::printf("sizeof(Token)   %zu\n", sizeof(Token));
+    std::printf("sizeof(Literal) %zu\n", sizeof(Literal));
+
+    std::vector<Value> numbers{};
+    std::vector<Value> integers{};
+    std::vector<Value> strings{};
+    std::vector<Value> mixed{};
+    for (size_t i = 0; i < count; i++) {
+        numbers.push_back(Value{double(i % 17)});
+        integers.push_back(Value{int32_t(i % 17)});
+        strings.push_back(Value{std::string{"s"} + std::to_string(i % 17)});
+        if (i % 2 == 0) mixed.push_back(Value{double(i % 3)});
+        else mixed.push_back(Value{i % 3 == 0});
+    }
+
+    auto add = [&](const char* name, const std::vector<Value>& values, size_t times) {
+        double seconds = Bench::timeBest(runs, [&]() {
+            for (size_t r = 0; r < times; r++) {
+                for (size_t i = 1; i < count; i++) {
+                    Value sum = values[i - 1] + values[i];
+                    sink = sink + (sum == values[0] ? 1 : 0);
+                }
+            }
+        });
+        report(name, times * (count - 1), seconds);
+    };
+    auto equal = [&](const char* name, const std::vector<Value>& values) {
+        double seconds = Bench::timeBest(runs, [&]() {
+            size_t same = 0;
+            for (size_t r = 0; r < rounds; r++) {
+                for (size_t i = 1; i < count; i++) {
+                    if (values[i - 1] == values[i]) same++;
+                }
+            }
+            sink = sink + same;
+        });
+        report(name, rounds * (count - 1), seconds);
+    };
+
+    // The sums are compared once too, so + includes one ==
+    add("operator+ numbers", numbers, rounds);
+    add("operator+ integers", integers, rounds);
+    add("operator+ strings", strings, rounds / 10);
+    equal("operator== numbers", numbers);
+    equal("operator== integers", integers);
+    equal("operator== strings", strings);
+    equal("operator== mixed types", mixed);
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+# lox_add_executable(TARGET SCRIPT)
+#
+# Transpile the Lox script SCRIPT with loxc and build it into the executable
+# TARGET, linked against the interpreter runtime. The generated C++ goes to
+# the current binary directory as TARGET.cpp and is remade when the script
+# or loxc changes.
+function(lox_add_executable TARGET SCRIPT)
+    get_filename_component(SCRIPT_PATH ${SCRIPT} ABSOLUTE)
+    set(GENERATED ${CMAKE_CURRENT_BINARY_DIR}/${TARGET}.cpp)
+    add_custom_command(
+        OUTPUT ${GENERATED}
+        COMMAND loxc ${SCRIPT_PATH} -o ${GENERATED}
+        DEPENDS loxc ${SCRIPT_PATH}
+        COMMENT "Transpiling ${SCRIPT} with loxc"
+        VERBATIM
+    )
+    add_executable(${TARGET} ${GENERATED})
+    target_link_libraries(${TARGET} lox_core)
+endfunction()
@@ -0,0 +1,44 @@
+#ifndef AOT_FUNCTION_HPP
+#define AOT_FUNCTION_HPP
+
+#include "lox_callable.hpp"
+#include "cell.hpp"
+
+#include <vector>
+
+namespace Lox {
+
+// A Lox function that loxc turned into a C++ function. The body gets the
+// closure, for its upvalues, and at least `params` arguments.
+class AotFunction : public LoxCallable {
+public:
+    using Body = Value (*)(AotFunction* self, const Value* args);
+
+    AotFunction(Body body, int params, Upvalues upvalues)
+    : body{body}, params{params}, upvalues{std::move(upvalues)}
+    {}
+    virtual ~AotFunction() override = default;
+
+    virtual int arity() override;
+    virtual Value call(Interpreter*, size_t argc) override;
+    virtual AotFunction* asAotFunction() override {return this;}
+
+    // As the interpreter calls functions: missing arguments are nil, extra
+    // ones are dropped
+    Value invoke(const Value* args, size_t argc) {
+        if (argc >= static_cast<size_t>(params)) return body(this, args);
+        std::vector<Value> padded{args, args + argc};
+        padded.resize(params);
+        return body(this, padded.data());
+    }
+
+    Body body;
+    int params;
+    // Just the variables the body uses from enclosing functions, in the
+    // order of Function::upvalues
+    Upvalues upvalues;
+};
+
+} // Lox namespace
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef AOT_RUNTIME_HPP
+#define AOT_RUNTIME_HPP
+
+#include "aot_function.hpp"
+#include "cell.hpp"
+#include "global_table.hpp"
+#include "value.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace Lox {
+
+class Interpreter;
+
+// What the C++ that loxc generates calls into. Every operation checks its
+// operands and reports errors exactly as the Interpreter does; the fast
+// paths are inline so the C++ compiler sees through them.
+class Aot {
+public:
+    // Run a transpiled script's top-level code, report a runtime error the
+    // way lox does and return the exit status it would have
+    static int run(void (*script)());
+
+    // The global called `name`, next to the natives
+    static Global* global(std::string_view name);
+
+    static Value get(int line, Global* global) {
+        if (!global->defined) undefinedVariable(line, global);
+        return global->value;
+    }
+    static void set(int line, Global* global, const Value& value) {
+        if (!global->defined) undefinedAssignment(line, global);
+        global->value = value;
+    }
+    static void define(Global* global, Value value) {
+        global->value = std::move(value);
+        global->defined = true;
+    }
+
+    static bool isTruthy(const Value& v) {
+        if (v.isNil()) return false;
+        if (v.isBool()) return v.asBool();
+        return true;
+    }
+
+    // Arithmetic only makes nil out of operands of the wrong type
+    static Value add(int line, const Value& l, const Value& r) {
+        Value result = l + r;
+        if (result.isNil()) checkAddition(line, l, r);
+        return result;
+    }
+    static Value subtract(int line, const Value& l, const Value& r) {
+        Value result = l - r;
+        if (result.isNil()) checkNumbers(line, l, r);
+        return result;
+    }
+    static Value multiply(int line, const Value& l, const Value& r) {
+        Value result = l * r;
+        if (result.isNil()) checkNumbers(line, l, r);
+        return result;
+    }
+    static Value divide(int line, const Value& l, const Value& r) {
+        Value result = l / r;
+        if (result.isNil()) checkNumbers(line, l, r);
+        return result;
+    }
+    static Value negate(int line, const Value& v) {
+        if (!v.isNumber()) checkNumber(line, v);
+        return -v;
+    }
+
+    static Value greater(int line, const Value& l, const Value& r) {
+        if (!l.isInt() || !r.isInt()) checkNumbers(line, l, r);
+        return Value{l > r};
+    }
+    static Value greaterEqual(int line, const Value& l, const Value& r) {
+        if (!l.isInt() || !r.isInt()) checkNumbers(line, l, r);
+        return Value{l >= r};
+    }
+    static Value less(int line, const Value& l, const Value& r) {
+        if (!l.isInt() || !r.isInt()) checkNumbers(line, l, r);
+        return Value{l < r};
+    }
+    static Value lessEqual(int line, const Value& l, const Value& r) {
+        if (!l.isInt() || !r.isInt()) checkNumbers(line, l, r);
+        return Value{l <= r};
+    }
+
+    // Transpiled functions are called directly, natives through the
+    // interpreter that defines them
+    static Value call(int line, const Value& callee, const Value* args, size_t argc) {
+        if (!callee.isCallable()) notCallable(line);
+        auto* callable = callee.asCallable();
+        if (auto* function = callable->asAotFunction()) return function->invoke(args, argc);
+        return callNative(callable, args, argc);
+    }
+
+    static void print(const Value&);
+
+private:
+    static Interpreter& interpreter();
+    static Value callNative(LoxCallable*, const Value* args, size_t argc);
+
+    // These throw a RuntimeError, unless the check passes
+    static void checkNumber(int line, const Value&);
+    static void checkNumbers(int line, const Value&, const Value&);
+    static void checkAddition(int line, const Value&, const Value&);
+    [[noreturn]] static void undefinedVariable(int line, Global*);
+    [[noreturn]] static void undefinedAssignment(int line, Global*);
+    [[noreturn]] static void notCallable(int line);
+};
+
+} // Lox namespace
+
+#endif
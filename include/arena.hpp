@@ -0,0 +1,126 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Lox {
+
+// Whether an arena object's destructor has to run. Types whose instances only
+// sometimes own resources can overload this next to their definition.
+template<typename T>
+bool needsRelease(const T&) {return true;}
+
+// A fixed run of objects placed contiguously in an arena. It does not own
+// them; the arena does.
+template<typename T>
+class ArenaArray {
+public:
+    T* begin() const {return items;}
+    T* end() const {return items + count;}
+    size_t size() const {return count;}
+    bool empty() const {return count == 0;}
+    T& operator[](size_t index) const {return items[index];}
+
+    T* items = nullptr;
+    uint32_t count = 0;
+};
+
+// Bump allocator for everything that lives exactly as long as one program.
+// Objects are carved out of large blocks and never freed one by one; the
+// destructors of the few that need one are run when the whole arena goes.
+class Arena {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena();
+
+    void* allocate(size_t size, size_t alignment);
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            if (needsRelease(*object)) onRelease(object, 1, &destroy<T>);
+        }
+        return object;
+    }
+
+    // Move scratch[from...] into the arena and drop it from the scratch
+    // vector. Nested lists can share one scratch vector as a stack.
+    template<typename T>
+    ArenaArray<T> array(std::vector<T>& scratch, size_t from) {
+        auto result = array<T>(
+            std::make_move_iterator(scratch.begin() + from),
+            std::make_move_iterator(scratch.end()),
+            scratch.size() - from
+        );
+        scratch.erase(scratch.begin() + from, scratch.end());
+        return result;
+    }
+
+    template<typename T>
+    ArenaArray<T> array(std::initializer_list<T> items) {
+        return array<T>(items.begin(), items.end(), items.size());
+    }
+
+    // Bytes handed out so far
+    size_t used() const {return _used;}
+
+private:
+    class Block {
+    public:
+        Block* next;
+        size_t size;
+    };
+
+    class Finalizer {
+    public:
+        void (*destroy)(void*, size_t);
+        void* objects;
+        size_t count;
+        Finalizer* next;
+    };
+
+    template<typename T>
+    static void destroy(void* objects, size_t count) {
+        for (size_t i = 0; i < count; i++) static_cast<T*>(objects)[i].~T();
+    }
+
+    template<typename T, typename It>
+    ArenaArray<T> array(It first, It last, size_t count) {
+        ArenaArray<T> result{};
+        if (count == 0) return result;
+        result.items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (T* slot = result.items; first != last; ++first, ++slot) {
+            new (slot) T(*first);
+        }
+        result.count = static_cast<uint32_t>(count);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            onRelease(result.items, count, &destroy<T>);
+        }
+        return result;
+    }
+
+    void onRelease(void* objects, size_t count, void (*destroy)(void*, size_t));
+    void grow(size_t minimum);
+
+    Block* _blocks = nullptr;
+    char* _next = nullptr;
+    char* _limit = nullptr;
+    Finalizer* _finalizers = nullptr;
+    size_t _used = 0;
+};
+
+} // Lox namespace
+
+#endif
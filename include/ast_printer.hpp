@@ -13,9 +13,9 @@
 
 namespace Lox {
 
-class AstPrinter : public ExprVisitor<std::string> {
+class AstPrinter {
 public: 
-    virtual ~AstPrinter() override = default;
+    ~AstPrinter() = default;
 
     void main(const std::vector<std::string>& args) {
         // std::unique_ptr<Expr> expr = std::make_unique<Binary>(
@@ -32,11 +32,11 @@ public:
         // std::cout<<print(expr);
     }
 
-    std::string print(std::unique_ptr<Expr>& expr){
+    std::string print(Expr* expr){
         return expr->accept(this);
     }
 
-    std::string parenthesize(const std::string& name, std::unique_ptr<Expr>& expr) {
+    std::string parenthesize(const std::string& name, Expr* expr) {
         std::stringstream builder{};
 
         builder << "(" << name;
@@ -46,7 +46,7 @@ public:
         return builder.str();
     }
 
-    std::string parenthesize(const std::string& name, std::unique_ptr<Expr>& expr1,std::unique_ptr<Expr>& expr2) {
+    std::string parenthesize(const std::string& name, Expr* expr1, Expr* expr2) {
         std::stringstream builder{};
 
         builder << "(" << name;
@@ -57,39 +57,84 @@ public:
         return builder.str();
     }
 
+    // Nodes only keep the operator's type, so spell it out again
+    static std::string lexeme(TokenType op) {
+        switch (op)
+        {
+        case TokenType::MINUS: return "-";
+        case TokenType::PLUS: return "+";
+        case TokenType::SLASH: return "/";
+        case TokenType::STAR: return "*";
+        case TokenType::BANG: return "!";
+        case TokenType::BANG_EQUAL: return "!=";
+        case TokenType::EQUAL_EQUAL: return "==";
+        case TokenType::GREATER: return ">";
+        case TokenType::GREATER_EQUAL: return ">=";
+        case TokenType::LESS: return "<";
+        case TokenType::LESS_EQUAL: return "<=";
+        case TokenType::AND: return "and";
+        case TokenType::OR: return "or";
+        default: return "?";
+        }
+    }
+
     // Describers
-    virtual std::string visitBinaryExpr(Binary* b) override {
-        return parenthesize(b->op.lexeme,b->left,b->right);
+    std::string visitBinaryExpr(Binary* b) {
+        return parenthesize(lexeme(b->op),b->left,b->right);
     }
 
-    virtual std::string visitGroupingExpr(Grouping* g) override {
+    std::string visitGroupingExpr(Grouping* g) {
         return parenthesize("group",g->expression);
     }
 
-    virtual std::string visitUnaryExpr(Unary* u) override {
-        return parenthesize(u->op.lexeme, u->expression);
+    std::string visitUnaryExpr(Unary* u) {
+        return parenthesize(lexeme(u->op), u->expression);
     }
 
-    virtual std::string visitLiteralExpr(Literal* l) override {
-        auto& val = l->value.item;
+    std::string visitLiteralExpr(Literal* l) {
+        auto& val = l->value;
         // Float
-        if (std::holds_alternative<double>(val)) {
-            return std::to_string(std::get<double>(val));
+        if (val.isNumber()) {
+            return std::to_string(val.asNumber());
         // String
-        } else if (std::holds_alternative<std::string>(val)) {
-            return std::get<std::string>(val);
+        } else if (val.isString()) {
+            return std::string{val.asString()};
         // Bool
-        } else if (std::holds_alternative<bool>(val)) {
-            return std::to_string(std::get<bool>(val));
+        } else if (val.isBool()) {
+            return std::to_string(val.asBool());
         // Null
-        } else if (std::holds_alternative<std::monostate>(val)) {
+        } else if (val.isNil()) {
             return "nil";
         // Error
         } else {
-            throw std::runtime_error("Unexpected type in variant");
+            throw std::runtime_error("Unexpected type of literal");
         }
     }
 
+    std::string visitVariableExpr(Variable* v) {
+        return std::string{v->name.text()};
+    }
+
+    std::string visitAssignExpr(Assign* a) {
+        return parenthesize("= " + std::string{a->name.text()}, a->value);
+    }
+
+    std::string visitLogicalExpr(Logical* l) {
+        return parenthesize(lexeme(l->op), l->left, l->right);
+    }
+
+    std::string visitCallExpr(Call* c) {
+        std::stringstream builder{};
+
+        builder << "(call " << c->callee->accept(this);
+        for (auto* argument : c->arguments) {
+            builder << " " << argument->accept(this);
+        }
+        builder << ")";
+
+        return builder.str();
+    }
+
 };
 
 } // Lox namespace
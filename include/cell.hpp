@@ -0,0 +1,25 @@
+#ifndef CELL_HPP
+#define CELL_HPP
+
+#include "value.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace Lox {
+
+// A local variable some closure captures. The frame that declares it and
+// every closure using it share the one cell, so an assignment through any
+// of them is seen by all, and the cell lives as long as the last of them.
+class Cell {
+public:
+    Value value;
+};
+
+// A closure's captured variables, in the order its Function::upvalues
+// lists them
+using Upvalues = std::vector<std::shared_ptr<Cell>>;
+
+} // Lox namespace
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef CHAR_CLASS_HPP
+#define CHAR_CLASS_HPP
+
+#include "token_type.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace Lox {
+
+// What the scanner does when it sees a character at the start of a lexeme
+enum class CharAction : uint8_t {
+    INVALID,
+    SKIP,
+    NEWLINE,
+    SINGLE,         // Always a one-character token
+    WITH_EQUAL,     // One-character token, or a two-character one if '=' follows
+    SLASH,          // Division or the start of a comment
+    STRING,
+    NUMBER,
+    IDENTIFIER
+};
+
+// Per-character property bits
+enum CharFlag : uint8_t {
+    ALPHA = 1 << 0,     // Can start an identifier
+    DIGIT = 1 << 1,
+    SPACE = 1 << 2      // Whitespace that is not a newline
+};
+
+class CharClass {
+public:
+    CharAction action;
+    uint8_t flags;
+    // Token produced for SINGLE/WITH_EQUAL characters
+    TokenType single;
+    // Token produced for WITH_EQUAL characters followed by '='
+    TokenType withEqual;
+};
+
+namespace detail {
+
+constexpr std::array<CharClass, 256> buildCharTable() {
+    std::array<CharClass, 256> table{};
+    for (auto& entry : table) {
+        entry = CharClass{CharAction::INVALID, 0, TokenType::END, TokenType::END};
+    }
+
+    auto single = [&table](char c, TokenType type) {
+        table[static_cast<unsigned char>(c)] = CharClass{CharAction::SINGLE, 0, type, type};
+    };
+    auto withEqual = [&table](char c, TokenType type, TokenType equalType) {
+        table[static_cast<unsigned char>(c)] = CharClass{CharAction::WITH_EQUAL, 0, type, equalType};
+    };
+
+    single('(', TokenType::LEFT_PAREN);
+    single(')', TokenType::RIGHT_PAREN);
+    single('{', TokenType::LEFT_BRACE);
+    single('}', TokenType::RIGHT_BRACE);
+    single(',', TokenType::COMMA);
+    single('.', TokenType::DOT);
+    single('-', TokenType::MINUS);
+    single('+', TokenType::PLUS);
+    single(';', TokenType::SEMICOLON);
+    single('*', TokenType::STAR);
+    withEqual('!', TokenType::BANG, TokenType::BANG_EQUAL);
+    withEqual('=', TokenType::EQUAL, TokenType::EQUAL_EQUAL);
+    withEqual('<', TokenType::LESS, TokenType::LESS_EQUAL);
+    withEqual('>', TokenType::GREATER, TokenType::GREATER_EQUAL);
+
+    table['/'].action = CharAction::SLASH;
+    table['/'].single = TokenType::SLASH;
+    table['"'].action = CharAction::STRING;
+    table['\n'].action = CharAction::NEWLINE;
+    for (char c : {' ', '\r', '\t'}) {
+        table[static_cast<unsigned char>(c)] = CharClass{CharAction::SKIP, SPACE, TokenType::END, TokenType::END};
+    }
+    for (int c = '0'; c <= '9'; c++) {
+        table[c] = CharClass{CharAction::NUMBER, DIGIT, TokenType::END, TokenType::END};
+    }
+    for (int c = 'a'; c <= 'z'; c++) {
+        table[c] = CharClass{CharAction::IDENTIFIER, ALPHA, TokenType::END, TokenType::END};
+    }
+    for (int c = 'A'; c <= 'Z'; c++) {
+        table[c] = CharClass{CharAction::IDENTIFIER, ALPHA, TokenType::END, TokenType::END};
+    }
+    table['_'] = CharClass{CharAction::IDENTIFIER, ALPHA, TokenType::END, TokenType::END};
+
+    return table;
+}
+
+} // detail namespace
+
+inline constexpr std::array<CharClass, 256> CHAR_TABLE = detail::buildCharTable();
+
+inline const CharClass& charClass(char c) {
+    return CHAR_TABLE[static_cast<unsigned char>(c)];
+}
+
+inline bool isDigitChar(char c) {
+    return charClass(c).flags & DIGIT;
+}
+
+inline bool isAlphaChar(char c) {
+    return charClass(c).flags & ALPHA;
+}
+
+inline bool isAlphaNumericChar(char c) {
+    return charClass(c).flags & (ALPHA | DIGIT);
+}
+
+} // Lox namespace
+
+#endif
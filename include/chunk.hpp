@@ -0,0 +1,92 @@
+#ifndef CHUNK_HPP
+#define CHUNK_HPP
+
+#include "value.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Lox {
+
+class Function;
+class Global;
+
+// Instructions of the bytecode VM. Each is one byte, followed by its
+// operands: slots are 16 bits, indices into a chunk's pools and jump
+// distances 32 bits, argument counts 16 bits.
+enum class OpCode : uint8_t {
+    CONSTANT,       // index: push constants[index]
+    NIL,
+    TRUE,
+    FALSE,
+    POP,
+    // Locals, in the places the resolver gave them, see Storage
+    GET_LOCAL,      // slot
+    SET_LOCAL,      // slot, leaves the value on the stack
+    STORE_LOCAL,    // slot, pops the value
+    GET_CELL,       // slot
+    SET_CELL,       // slot
+    DEFINE_CELL,    // slot, pops the value into a new cell
+    NEW_CELL,       // slot: an empty cell, for a function that captures itself
+    GET_UPVALUE,    // index
+    SET_UPVALUE,    // index
+    GET_GLOBAL,     // index into globals
+    SET_GLOBAL,     // index
+    DEFINE_GLOBAL,  // index, pops the value
+    // Operators, on the top one or two values
+    EQUAL,
+    NOT_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    NOT,
+    NEGATE,
+    PRINT,
+    // Control flow; distances count from the end of the instruction
+    JUMP,               // distance forwards
+    JUMP_IF_FALSE,      // distance, leaves the condition on the stack
+    JUMP_IF_TRUE,       // distance, leaves the condition on the stack
+    POP_JUMP_IF_FALSE,  // distance, pops the condition
+    LOOP,               // distance backwards
+    CALL,               // argument count
+    CLOSURE,            // index into functions
+    RETURN
+};
+
+// Where a run of instructions from the same source line starts
+class LineStart {
+public:
+    uint32_t offset;
+    int line;
+};
+
+// The compiled code of a function body or of a program's top level. Owned by
+// the program's arena, like the syntax tree it was compiled from.
+class Chunk {
+public:
+    std::vector<uint8_t> code;
+    std::vector<Value> constants;
+    std::vector<Global*> globals;
+    std::vector<Function*> functions;
+    std::vector<LineStart> lines;
+    // Parameters that closures capture, to be moved into cells on entry
+    std::vector<uint16_t> cellParams;
+    // Stack and cell slots a call needs, see Function, and the most
+    // temporaries the code has on the stack above them at once
+    int frameSize = 0;
+    int cells = 0;
+    int maxStack = 0;
+
+    // Source line of the instruction covering `offset`
+    int line(size_t offset) const;
+};
+
+} // Lox namespace
+
+#endif
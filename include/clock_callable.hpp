@@ -13,7 +13,7 @@ public:
     virtual ~ClockCallable() override = default;
 
     virtual int arity() override;
-    virtual Value call(Interpreter*, std::list<Value>&) override;
+    virtual Value call(Interpreter*, size_t argc) override;
 private:
 };
 
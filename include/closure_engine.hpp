@@ -0,0 +1,86 @@
+#ifndef CLOSURE_ENGINE_HPP
+#define CLOSURE_ENGINE_HPP
+
+#include "arena.hpp"
+#include "cell.hpp"
+#include "expr.hpp"
+#include "frame_stack.hpp"
+#include "stmt.hpp"
+#include "program.hpp"
+#include "value.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace Lox {
+
+class ClosureEngine;
+class Interpreter;
+class LoxCallable;
+
+// A node lowered to a C++ function object, with everything the tree-walker
+// looks up per visit (operator, storage and slot, literal value, line)
+// bound when it was built
+using ExprFn = std::function<Value(ClosureEngine&)>;
+using StmtFn = std::function<Completion(ClosureEngine&)>;
+
+// A function body lowered for the closure engine. Lives in the program's
+// arena, next to the syntax tree it came from.
+class LoweredBody {
+public:
+    std::vector<StmtFn> statements;
+};
+
+// Runs programs for --engine=closure. The resolved tree is walked once and
+// each node becomes a function object calling its children's directly, so
+// running it is one indirect call per node and nothing else is decided at
+// runtime. Frames and globals work exactly as in the Interpreter; both run
+// calls on a FrameStack.
+class ClosureEngine : private FrameStack {
+public:
+    // Natives are called with `interpreter`, as the tree-walker calls them
+    explicit ClosureEngine(Interpreter* interpreter);
+    ~ClosureEngine() = default;
+
+    void interpret(Program&);
+
+    // Expr visitor, building the lowered form
+    void visitBinaryExpr(Binary*);
+    void visitGroupingExpr(Grouping*);
+    void visitUnaryExpr(Unary*);
+    void visitLiteralExpr(Literal*);
+    void visitVariableExpr(Variable*);
+    void visitAssignExpr(Assign*);
+    void visitLogicalExpr(Logical*);
+    void visitCallExpr(Call*);
+
+    // Stmt visitor
+    void visitExpressionStmt(Expression*);
+    void visitFunctionStmt(Function*);
+    void visitReturnStmt(Return*);
+    void visitVarStmt(Var*);
+    void visitPrintStmt(Print*);
+    void visitBlockStmt(Block*);
+    void visitIfStmt(If*);
+    void visitWhileStmt(While*);
+
+private:
+    Interpreter* _interpreter;
+    // Where lowered function bodies go, and what the last visit built
+    Arena* _arena;
+    ExprFn _expr;
+    StmtFn _stmt;
+
+    ExprFn lower(Expr*);
+    StmtFn lower(Stmt*);
+    std::vector<StmtFn> lower(const ArenaArray<Stmt*>&);
+    LoweredBody* lowerBody(Function*);
+    StmtFn define(Storage, int slot, Global*, ExprFn);
+
+    Value call(LoxCallable*, size_t argc);
+    Value executeCall(Function*, const Upvalues&, size_t argc);
+};
+
+} // Lox namespace
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef COMPACT_TOKEN_HPP
+#define COMPACT_TOKEN_HPP
+
+#include "token.hpp"
+#include "token_type.hpp"
+#include "value.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+namespace Lox {
+
+// A token that does not own its text. The lexeme lives in the source buffer
+// the token was scanned from and literals are only decoded on request, so
+// scanning never touches the heap beyond growing the token vector.
+class CompactToken {
+public:
+    std::string_view lexeme(std::string_view source) const {
+        return source.substr(offset, length);
+    }
+
+    // Decode the literal value of a NUMBER or STRING token, or the interned
+    // name of an IDENTIFIER
+    Value literal(std::string_view source) const {
+        return decodeLiteral(type, lexeme(source));
+    }
+    // Build a self-contained Token for code that still needs one
+    Token materialize(std::string_view source) const {
+        return withLexeme(lexeme(source));
+    }
+    // Same, for a token whose lexeme is stored somewhere else
+    Token withLexeme(std::string_view lexeme) const;
+
+    static Value decodeLiteral(TokenType type, std::string_view lexeme);
+
+    TokenType type;
+    uint32_t offset;
+    uint32_t length;
+    int line;
+};
+
+} // Lox namespace
+
+#endif
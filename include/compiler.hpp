@@ -0,0 +1,75 @@
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include "arena.hpp"
+#include "chunk.hpp"
+#include "expr.hpp"
+#include "stmt.hpp"
+#include "program.hpp"
+
+#include <cstdint>
+
+namespace Lox {
+
+// Lowers a resolved syntax tree to bytecode for the VM. Variables keep the
+// storage and slots the resolver gave them, so the compiler only has to
+// pick the matching instruction. Function bodies get chunks of their own,
+// compiled along with the code declaring them, except that a body still
+// waiting under --lazy is compiled on its first call.
+class Compiler {
+public:
+    Compiler() = default;
+
+    Chunk* compile(Program&);
+    // Compile a function body that was parsed and resolved late
+    void compile(Function*, Arena&);
+
+    // Expr visitor
+    void visitBinaryExpr(Binary*);
+    void visitGroupingExpr(Grouping*);
+    void visitUnaryExpr(Unary*);
+    void visitLiteralExpr(Literal*);
+    void visitVariableExpr(Variable*);
+    void visitAssignExpr(Assign*);
+    void visitLogicalExpr(Logical*);
+    void visitCallExpr(Call*);
+
+    // Stmt visitor
+    void visitExpressionStmt(Expression*);
+    void visitFunctionStmt(Function*);
+    void visitReturnStmt(Return*);
+    void visitVarStmt(Var*);
+    void visitPrintStmt(Print*);
+    void visitBlockStmt(Block*);
+    void visitIfStmt(If*);
+    void visitWhileStmt(While*);
+
+private:
+    Arena* _arena = nullptr;
+    Chunk* _chunk = nullptr;
+    // Line the next instructions are reported against
+    int _line = 0;
+    // Temporaries on the stack at this point of the chunk
+    int _depth = 0;
+
+    Chunk* compileFunction(Function*);
+    void compile(Expr*);
+    void compile(Stmt*);
+    void store(Storage, int slot, Global*, bool define);
+
+    void emit(OpCode, int stackEffect);
+    void emitSlot(OpCode, int stackEffect, int slot);
+    void emitIndex(OpCode, int stackEffect, size_t index);
+    // A forward jump, to be pointed at its target by patchJump
+    size_t emitJump(OpCode, int stackEffect);
+    void patchJump(size_t operand);
+    void emitLoop(size_t start);
+    void emitConstant(const Value&);
+    void emitGlobal(OpCode, int stackEffect, Global*);
+    void write16(uint16_t);
+    void write32(uint32_t);
+};
+
+} // Lox namespace
+
+#endif
@@ -2,10 +2,11 @@
 #define EXPR_HPP
 
 #include "token.hpp"
+#include "token_type.hpp"
 #include "value.hpp"
+#include "arena.hpp"
 
 #include <string>
-#include <list>
 #include <memory>
 
 namespace Lox {
@@ -18,39 +19,52 @@ class Assign;
 class Literal;
 class Logical;
 class Call;
-
-//==============================================================================
-// Abstract Visitor
-//==============================================================================
-template<typename T>
-class ExprVisitor {
-public:
-    virtual ~ExprVisitor(){}
-
-    virtual T visitBinaryExpr(Binary*) = 0;
-    virtual T visitGroupingExpr(Grouping*) = 0;
-    virtual T visitUnaryExpr(Unary*) = 0;
-    virtual T visitLiteralExpr(Literal*) = 0;
-    virtual T visitVariableExpr(Variable*) = 0;
-    virtual T visitAssignExpr(Assign*) = 0;
-    virtual T visitLogicalExpr(Logical*) = 0;
-    virtual T visitCallExpr(Call*) = 0;
-
+class Global;
+
+// Where the resolver decided a variable lives: in the global table, in a slot
+// of the running call's stack frame, in a Cell of that frame when a closure
+// captures the variable, or, inside the closure, in one of its upvalues
+enum class Storage : uint8_t {
+    GLOBAL,
+    STACK,
+    CELL,
+    UPVALUE
 };
 
 //==============================================================================
 // Abstract expression
 //==============================================================================
+enum class ExprKind : uint8_t {
+    BINARY,
+    GROUPING,
+    UNARY,
+    LITERAL,
+    VARIABLE,
+    ASSIGN,
+    LOGICAL,
+    CALL
+};
 
+// Nodes live in their program's arena and are never deleted through a base
+// pointer, so the destructor is not virtual. That keeps nodes whose fields are
+// all trivial trivially destructible, and the arena can simply forget them.
+//
+// Nothing is virtual: each node is tagged with its kind, and accept switches
+// on it. A visitor is any class with a visit<Kind>Expr(Kind*) method for
+// every kind, all returning the same type; they are called directly, so the
+// compiler can inline them into the switch.
 class Expr {
-
 public:
-    virtual ~Expr(){}
+    ~Expr() = default;
 
-    virtual void accept(ExprVisitor<void>*) = 0;
-    virtual std::string accept(ExprVisitor<std::string>*) = 0;
-    virtual Value accept(ExprVisitor<Value>*) = 0;
+    template<typename Visitor>
+    auto accept(Visitor* visitor);
 
+    const ExprKind kind;
+
+protected:
+    explicit Expr(ExprKind kind) : kind{kind}
+    {}
 };
 
 //==============================================================================
@@ -59,200 +73,130 @@ public:
 
 class Binary : public Expr {
 public:
-    Binary(std::unique_ptr<Expr> l, const Token& op, std::unique_ptr<Expr> r) 
-    : left{std::move(l)}, op{op},  right{std::move(r)}
+    Binary(Expr* left, TokenType op, int line, Expr* right)
+    : Expr{ExprKind::BINARY}, left{left}, op{op}, line{line}, right{right}
     {}
-    virtual ~Binary() override = default;
-
-    virtual void accept(ExprVisitor<void>* visitor) override {
-        visitor->visitBinaryExpr(this);
-    }
-
-    virtual std::string accept(ExprVisitor<std::string>* visitor) override {
-        return visitor->visitBinaryExpr(this);
-    }
-
-    virtual Value accept(ExprVisitor<Value>* visitor) override {
-        return visitor->visitBinaryExpr(this);
-    }
 
-    std::unique_ptr<Expr> left;
-    Token op;
-    std::unique_ptr<Expr> right;
+    Expr* left;
+    TokenType op;
+    int line;
+    Expr* right;
 
 };
 
 class Grouping : public Expr {
 public:
-    Grouping(std::unique_ptr<Expr> expr)
-    : expression{std::move(expr)}
+    explicit Grouping(Expr* expression)
+    : Expr{ExprKind::GROUPING}, expression{expression}
     {}
-    virtual ~Grouping() override = default;
 
-    virtual void accept(ExprVisitor<void>* visitor) override {
-        visitor->visitGroupingExpr(this);
-    }
-
-    virtual std::string accept(ExprVisitor<std::string>* visitor) override {
-        return visitor->visitGroupingExpr(this);
-    }
-
-    virtual Value accept(ExprVisitor<Value>* visitor) override {
-        return visitor->visitGroupingExpr(this);
-    }
-
-    std::unique_ptr<Expr> expression;
+    Expr* expression;
 };
 
 class Unary : public Expr {
 public:
-    Unary(const Token& op, std::unique_ptr<Expr> expr)
-    : op{op}, expression{std::move(expr)}
+    Unary(TokenType op, int line, Expr* expression)
+    : Expr{ExprKind::UNARY}, op{op}, line{line}, expression{expression}
     {}
-    virtual ~Unary() override = default;
-
-    virtual void accept(ExprVisitor<void>* visitor) override {
-        visitor->visitUnaryExpr(this);
-    }
 
-    virtual std::string accept(ExprVisitor<std::string>* visitor) override {
-        return visitor->visitUnaryExpr(this);
-    }
-
-    virtual Value accept(ExprVisitor<Value>* visitor) override {
-        return visitor->visitUnaryExpr(this);
-    }
-
-    Token op;
-    std::unique_ptr<Expr> expression;
+    TokenType op;
+    int line;
+    Expr* expression;
 
 }; 
 
 class Literal : public Expr {
 public:
-    explicit Literal(const double& v) : value{v}
+    explicit Literal(const double& v) : Expr{ExprKind::LITERAL}, value{v}
     {}
-    explicit Literal(const bool& v) : value{v}
+    explicit Literal(const bool& v) : Expr{ExprKind::LITERAL}, value{v}
     {}
-    explicit Literal(const std::string& v) : value{v}
+    explicit Literal(const std::string& v) : Expr{ExprKind::LITERAL}, value{v}
     {}
-    explicit Literal(const std::monostate& v) : value{v}
+    Literal(const Value& v) : Expr{ExprKind::LITERAL}, value{v}
     {}
-    explicit Literal(const std::shared_ptr<LoxCallable>& v) : value{v}
+    Literal(Value&& v) : Expr{ExprKind::LITERAL}, value{std::move(v)}
     {}
-    Literal(const Value& v) : value{v}
-    {}
-    virtual ~Literal() override = default;
-
-    virtual void accept(ExprVisitor<void>* visitor) override {
-        visitor->visitLiteralExpr(this);
-    }
-
-    virtual std::string accept(ExprVisitor<std::string>* visitor) override {
-        return visitor->visitLiteralExpr(this);
-    }
-
-    virtual Value accept(ExprVisitor<Value>* visitor) override {
-        return visitor->visitLiteralExpr(this);
-    }
 
     Value value;
 
 };
 
+// Numbers, booleans and nil own nothing, so the arena can skip destroying them
+inline bool needsRelease(const Literal& literal) {
+    return literal.value.isObject();
+}
+
 class Variable : public Expr {
 public:
-    explicit Variable(const Token& name) : name{name}
+    explicit Variable(Token name) : Expr{ExprKind::VARIABLE}, name{std::move(name)}
     {}
-    virtual ~Variable() override = default;
-
-    virtual void accept(ExprVisitor<void>* visitor) override {
-        visitor->visitVariableExpr(this);
-    }
-
-    virtual std::string accept(ExprVisitor<std::string>* visitor) override {
-        return visitor->visitVariableExpr(this);
-    }
-
-    virtual Value accept(ExprVisitor<Value>* visitor) override {
-        return visitor->visitVariableExpr(this);
-    }
 
     Token name;
+    // Set by the resolver. For locals `slot` indexes the current frame's
+    // stack or cells, for upvalues the running closure's; globals are found
+    // through `global`.
+    Storage storage = Storage::GLOBAL;
+    int slot = -1;
+    Global* global = nullptr;
 };
 
 class Assign : public Expr {
 public:
-    Assign(const Token& name, std::unique_ptr<Expr>& value) : name{name}, value{std::move(value)}
+    Assign(Token name, Expr* value) : Expr{ExprKind::ASSIGN}, name{std::move(name)}, value{value}
     {}
-    virtual ~Assign() override = default;
-
-    virtual void accept(ExprVisitor<void>* visitor) override {
-        visitor->visitAssignExpr(this);
-    }
-
-    virtual std::string accept(ExprVisitor<std::string>* visitor) override {
-        return visitor->visitAssignExpr(this);
-    }
-
-    virtual Value accept(ExprVisitor<Value>* visitor) override {
-        return visitor->visitAssignExpr(this);
-    }
 
     Token name;
-    std::unique_ptr<Expr> value;
+    Expr* value;
+    // See Variable
+    Storage storage = Storage::GLOBAL;
+    int slot = -1;
+    Global* global = nullptr;
 };
 
 class Logical : public Expr {
 public:
-    Logical(std::unique_ptr<Expr>& left, const Token& op, std::unique_ptr<Expr>& right) 
-        : left{std::move(left)}, op{op}, right{std::move(right)}
+    Logical(Expr* left, TokenType op, Expr* right)
+        : Expr{ExprKind::LOGICAL}, left{left}, op{op}, right{right}
     {}
-    virtual ~Logical() = default;
 
-    virtual void accept(ExprVisitor<void>* visitor) {
-        return visitor->visitLogicalExpr(this);
-    }
-
-    virtual std::string accept(ExprVisitor<std::string>* visitor) {
-        return visitor->visitLogicalExpr(this);
-    }
-
-    virtual Value accept(ExprVisitor<Value>* visitor) {
-        return visitor->visitLogicalExpr(this);
-    }
-
-    std::unique_ptr<Expr> left;
-    Token op;
-    std::unique_ptr<Expr> right;
+    Expr* left;
+    TokenType op;
+    Expr* right;
 
 };
 
 class Call : public Expr {
 
 public:
-    Call(std::unique_ptr<Expr>& callee, const Token paren, std::list<std::unique_ptr<Expr>>& args)
-    : callee{std::move(callee)}, paren{paren}, arguments{std::move(args)}
+    // `line` is where the closing parenthesis was, for runtime errors
+    Call(Expr* callee, int line, ArenaArray<Expr*> arguments)
+    : Expr{ExprKind::CALL}, callee{callee}, line{line}, arguments{arguments}
     {}
-    virtual ~Call() = default;
-
-    void accept(ExprVisitor<void>* visitor) {
-        visitor->visitCallExpr(this);
-    }
 
-    std::string accept(ExprVisitor<std::string>* visitor) {
-        return visitor->visitCallExpr(this);
-    }
-
-    Value accept(ExprVisitor<Value>* visitor) {
-        return visitor->visitCallExpr(this);
-    }
-
-    std::unique_ptr<Expr> callee;
-    Token paren;
-    std::list<std::unique_ptr<Expr>> arguments;
+    Expr* callee;
+    int line;
+    ArenaArray<Expr*> arguments;
 };
 
+//==============================================================================
+// Dispatch
+//==============================================================================
+template<typename Visitor>
+auto Expr::accept(Visitor* visitor) {
+    switch (kind) {
+    case ExprKind::BINARY: return visitor->visitBinaryExpr(static_cast<Binary*>(this));
+    case ExprKind::GROUPING: return visitor->visitGroupingExpr(static_cast<Grouping*>(this));
+    case ExprKind::UNARY: return visitor->visitUnaryExpr(static_cast<Unary*>(this));
+    case ExprKind::LITERAL: return visitor->visitLiteralExpr(static_cast<Literal*>(this));
+    case ExprKind::VARIABLE: return visitor->visitVariableExpr(static_cast<Variable*>(this));
+    case ExprKind::ASSIGN: return visitor->visitAssignExpr(static_cast<Assign*>(this));
+    case ExprKind::LOGICAL: return visitor->visitLogicalExpr(static_cast<Logical*>(this));
+    case ExprKind::CALL: break;
+    }
+    return visitor->visitCallExpr(static_cast<Call*>(this));
+}
+
 } // Lox namespace
 
 #endif
\ No newline at end of file
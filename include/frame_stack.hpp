@@ -0,0 +1,84 @@
+#ifndef FRAME_STACK_HPP
+#define FRAME_STACK_HPP
+
+#include "cell.hpp"
+#include "stmt.hpp"
+#include "value.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Lox {
+
+// The runtime state the tree-walker and the closure engine run calls on,
+// with the frame setup, teardown and capture both share. Only how a body's
+// statements are run differs between them.
+class FrameStack {
+protected:
+    FrameStack() = default;
+
+    // Uncaptured locals of every active call, one frame after the other,
+    // and apart from them the cells of captured ones, for the calls that
+    // have any. `_frame` and `_cellFrame` are where the running call's start.
+    std::vector<Value> _stack{};
+    Upvalues _cells{};
+    size_t _frame = 0;
+    size_t _cellFrame = 0;
+    // The running closure's captured variables, none at top level
+    const Upvalues* _upvalues = nullptr;
+    // Set by a return statement on its way out, see Completion
+    Value _returnValue{};
+
+    // Run `body` as a call of `function` whose `argc` arguments are on top
+    // of the value stack; they become the first slots of its frame. `run`
+    // executes one statement. Returns what the body returned.
+    template<typename Statements, typename Run>
+    Value executeFrame(Function* function, const Upvalues& upvalues, size_t argc, const Statements& body, Run run);
+
+    // The cells a new closure of `function` keeps
+    Upvalues capture(Function* function);
+};
+
+// A RuntimeError abandons the whole program, and interpret() resets the
+// stacks after one, so nothing here has to be undone on the way out
+template<typename Statements, typename Run>
+Value FrameStack::executeFrame(Function* function, const Upvalues& upvalues, size_t argc, const Statements& body, Run run) {
+    size_t base = _stack.size() - argc;
+    _stack.resize(base + function->frameSize);
+
+    // Captured parameters move into cells of their own
+    size_t cellBase = _cells.size();
+    if (function->cells > 0) {
+        _cells.resize(cellBase + function->cells);
+        for (size_t i = 0; i < function->params.size(); i++) {
+            auto& param = function->params[i];
+            if (param.storage == Storage::CELL) _cells[cellBase + param.slot] = std::make_shared<Cell>(Cell{_stack[base + i]});
+        }
+    }
+
+    auto previousFrame = _frame;
+    auto previousCellFrame = _cellFrame;
+    auto previousUpvalues = _upvalues;
+    _frame = base;
+    _cellFrame = cellBase;
+    _upvalues = &upvalues;
+
+    Value result{};
+    for (auto& statement : body) {
+        if (run(statement) == Completion::RETURN) {
+            result = std::move(_returnValue);
+            break;
+        }
+    }
+
+    _frame = previousFrame;
+    _cellFrame = previousCellFrame;
+    _upvalues = previousUpvalues;
+    _cells.resize(cellBase);
+    return result;
+}
+
+} // Lox namespace
+
+#endif
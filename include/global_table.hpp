@@ -0,0 +1,43 @@
+#ifndef GLOBAL_TABLE_HPP
+#define GLOBAL_TABLE_HPP
+
+#include "value.hpp"
+
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+
+namespace Lox {
+
+// A global variable. It exists as soon as any code mentions the name, but
+// only counts as defined once a declaration for it has run.
+class Global {
+public:
+    // Interned, and kept alive by the entry
+    Value name;
+    Value value;
+    bool defined = false;
+};
+
+// Every global name the resolver has seen, numbered densely. Entries never
+// move, so the resolver can hand their addresses to the nodes that use them
+// and no name is hashed at runtime. Names are interned strings, looked up
+// by address.
+class GlobalTable {
+public:
+    // The entry for `name`, an interned string, created undefined the first
+    // time
+    Global* intern(const Value& name);
+    Global* intern(std::string_view name);
+    void define(std::string_view name, Value value);
+
+    size_t size() const {return _globals.size();}
+
+private:
+    std::deque<Global> _globals;
+    std::unordered_map<const LoxString*, size_t> _ids;
+};
+
+} // Lox namespace
+
+#endif
@@ -3,7 +3,6 @@
 
 #include "lox.hpp"
 #include "value.hpp"
-#include "return_value.hpp"
 #include "lox_callable.hpp"
 #include "lox_function.hpp"
 #include "clock_callable.hpp"
@@ -11,7 +10,10 @@
 #include "expr.hpp"
 #include "stmt.hpp"
 #include "errors.hpp"
-#include "environment.hpp"
+#include "cell.hpp"
+#include "frame_stack.hpp"
+#include "global_table.hpp"
+#include "program.hpp"
 
 #include <memory>
 #include <variant>
@@ -24,53 +26,58 @@
 
 namespace Lox {
 
-class Interpreter : public ExprVisitor<Value>, public StmtVisitor<void> {
+class Interpreter : private FrameStack {
 public:
     Interpreter();
-    virtual ~Interpreter() override = default;
+    ~Interpreter() = default;
 
-    void interpret(std::unique_ptr<Expr>&);
-    void interpret(std::vector<std::unique_ptr<Stmt>>&);
-    void execute(std::unique_ptr<Stmt>&);
-    void resolve(Expr*,int);
-    void executeBlock(std::list<std::unique_ptr<Stmt>>&, std::shared_ptr<Environment>);
+    void interpret(Expr*);
+    void interpret(Program&);
+    Completion execute(Stmt*);
+    // Run the body of a call whose `argc` arguments are on top of the value
+    // stack; they become the first slots of its frame. Returns what the
+    // body returned.
+    Value executeCall(Function*, const Upvalues&, size_t argc);
+    // The `argc` arguments on top of the value stack, first one first
+    const Value* arguments(size_t argc) const {return _stack.data() + _stack.size() - argc;}
+    // Call `callable` with arguments that are not on the value stack, from
+    // code outside the tree
+    Value call(LoxCallable*, const Value* args, size_t argc);
 
-    // ExprVisitor<Value>
-    virtual Value visitBinaryExpr(Binary*) override;
-    virtual Value visitGroupingExpr(Grouping*) override;
-    virtual Value visitUnaryExpr(Unary*) override;
-    virtual Value visitLiteralExpr(Literal*) override;
-    virtual Value visitVariableExpr(Variable*) override;
-    virtual Value visitAssignExpr(Assign*) override;
-    virtual Value visitLogicalExpr(Logical*) override;
-    virtual Value visitCallExpr(Call*) override;
+    // Expr visitor
+    Value visitBinaryExpr(Binary*);
+    Value visitGroupingExpr(Grouping*);
+    Value visitUnaryExpr(Unary*);
+    Value visitLiteralExpr(Literal*);
+    Value visitVariableExpr(Variable*);
+    Value visitAssignExpr(Assign*);
+    Value visitLogicalExpr(Logical*);
+    Value visitCallExpr(Call*);
 
-    // StmtVisitor<void>
-    virtual void visitExpressionStmt(Expression*) override;
-    virtual void visitFunctionStmt(Function*) override;
-    virtual void visitReturnStmt(Return*) override;
-    virtual void visitVarStmt(Var*) override;
-    virtual void visitPrintStmt(Print*) override;
-    virtual void visitBlockStmt(Block*) override;
-    virtual void visitIfStmt(If*) override;
-    virtual void visitWhileStmt(While*) override;
+    // Stmt visitor
+    Completion visitExpressionStmt(Expression*);
+    Completion visitFunctionStmt(Function*);
+    Completion visitReturnStmt(Return*);
+    Completion visitVarStmt(Var*);
+    Completion visitPrintStmt(Print*);
+    Completion visitBlockStmt(Block*);
+    Completion visitIfStmt(If*);
+    Completion visitWhileStmt(While*);
 
-    std::shared_ptr<Environment> globals;
+    // How print shows a value
+    static std::string stringify(const Value&);
 
+    GlobalTable globals;
 
-private:
-    std::shared_ptr<Environment>& _environment;
-    std::unordered_map<Expr*, int> _locals;
 
+private:
     Value evaluate(Expr*);
-    Value evaluate(std::unique_ptr<Expr>&);
-    Value lookUpVariable(const Token&, Expr*);
+    void define(Storage, int slot, Global*, Value);
     bool isTruthy(const Value&);
-    std::string stringify(const Value&);
     
-    void checkNumberOperand(const Token&, const Value&);
-    void checkNumberOperands(const Token&, const Value&, const Value&);
-    void checkAdditionOperation(const Token&, const Value&, const Value&);
+    void checkNumberOperand(int, const Value&);
+    void checkNumberOperands(int, const Value&, const Value&);
+    void checkAdditionOperation(int, const Value&, const Value&);
 
 
 };
@@ -0,0 +1,73 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include "value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Lox {
+
+class Function;
+
+// What the JIT made of one function. Machine code takes the arguments as
+// doubles and returns 0 with the result in `out`, or 1 when a guard failed
+// and the interpreter has to run the call instead.
+class JitCode {
+public:
+    using Entry = int (*)(const double* args, double* out);
+
+    // Null when the function is outside what the JIT compiles, or once it
+    // has bailed out too often
+    Entry entry = nullptr;
+    uint32_t bails = 0;
+};
+
+// Baseline JIT for the tree-walker, x86-64 Linux only. A function called
+// THRESHOLD times is compiled to machine code if it only computes with
+// numbers: parameters and locals on the stack, number literals, arithmetic,
+// comparisons in conditions, if, while, return, and calls to global
+// functions. Arithmetic is done on doubles, which Lox numbers compute
+// exactly as. Such a body has no side effects, so whenever a guard fails
+// (an argument that is not a number, a callee that is not compiled, falling
+// off the end) the call is simply run again by the interpreter.
+class Jit {
+public:
+    static constexpr uint32_t THRESHOLD = 64;
+    static constexpr uint32_t MAX_BAILS = 64;
+
+    Jit() = default;
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+    ~Jit();
+
+    // --jit=off|on|check, off by default. Checking runs the interpreter
+    // after every compiled call too and reports results that differ.
+    bool enabled = false;
+    bool check = false;
+
+    // Run a call of `function` with the top `argc` values of `args` in
+    // machine code. False if it has to be interpreted.
+    bool run(Function*, const Value* args, size_t argc, Value& result);
+    // Compare a compiled call's result to the interpreter's, under check
+    void verify(Function*, const Value& compiled, const Value& interpreted);
+
+private:
+    class Region {
+    public:
+        void* memory;
+        size_t size;
+    };
+
+    std::vector<JitCode*> _code;
+    std::vector<Region> _regions;
+
+    JitCode* compile(Function*);
+    // Copy machine code into memory that can be executed but not written
+    void* install(const std::vector<uint8_t>& code);
+};
+
+} // Lox namespace
+
+#endif
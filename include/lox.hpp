@@ -2,6 +2,9 @@
 #define LOX_HPP
 
 #include "interpreter.hpp"
+#include "vm.hpp"
+#include "closure_engine.hpp"
+#include "jit.hpp"
 #include "resolver.hpp"
 #include "scanner.hpp"
 #include "token.hpp"
@@ -9,6 +12,13 @@
 #include "value.hpp"
 #include "ast_printer.hpp"
 #include "parser.hpp"
+#include "source_buffer.hpp"
+#include "streaming_scanner.hpp"
+#include "parallel_scanner.hpp"
+#include "compact_token.hpp"
+#include "token_source.hpp"
+#include "options.hpp"
+#include "program.hpp"
 
 #include <stdlib.h>
 #include <string>
@@ -16,6 +26,7 @@
 #include <iostream>
 #include <fstream>
 #include <list>
+#include <memory>
 
 namespace Lox 
 {
@@ -31,16 +42,28 @@ public:
     static void error(const int line, const std::string& message);
     static void error(const Token& token, const std::string& message);
     static void runtimeError(RuntimeError& error);
+    // Parse and resolve the body of a function declared under --lazy. Errors
+    // are reported as usual, then raised as a RuntimeError at the call.
+    static void compileDeferred(Function* function);
 
     static bool hadError;
     static bool hadRuntimeError;
     static Interpreter interpreter;
+    static VM vm;
+    static ClosureEngine closureEngine;
+    static Jit jit;
+    static Options options;
 private:
     void runFile(std::string& path);
     void runPrompt();
-    void run(std::string& source);
+    void run(std::shared_ptr<const SourceBuffer> source);
+    void run(TokenSource& tokens);
     static void report(const int line,const std::string& where,const std::string& message);
 
+    // Programs that ran. Functions they declared point into their arenas and
+    // can still be called from later REPL lines.
+    std::vector<std::unique_ptr<Program>> _programs;
+
 };
 
 } // namespace Lox
@@ -3,18 +3,26 @@
 
 #include "value.hpp"
 
-#include <list>
+#include <cstddef>
 
 namespace Lox {
 
 class Interpreter;
+class LoxFunction;
+class AotFunction;
 
-class LoxCallable{
+// Shared by Values through Object's reference count
+class LoxCallable : public Object {
 public:
     virtual ~LoxCallable(){}
 
     virtual int arity() = 0;
-    virtual Value call(Interpreter*, std::list<Value>&) = 0;
+    // The arguments are the top `argc` values of the interpreter's stack
+    virtual Value call(Interpreter*, size_t argc) = 0;
+    // The VM runs Lox functions itself and only calls into the rest
+    virtual LoxFunction* asFunction() {return nullptr;}
+    // Code loxc generated calls its own functions directly, the same way
+    virtual AotFunction* asAotFunction() {return nullptr;}
 };
 
 }
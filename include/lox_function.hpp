@@ -3,27 +3,30 @@
 
 #include "stmt.hpp"
 #include "lox_callable.hpp"
-#include "environment.hpp"
+#include "cell.hpp"
 #include "interpreter.hpp"
-#include "return_value.hpp"
 
 #include <memory>
-#include <list>
 #include <algorithm>
 
 namespace Lox {
 
 class LoxFunction : public LoxCallable {
 public:
-    explicit LoxFunction(Function*, std::shared_ptr<Environment>&);
+    LoxFunction(Function*, Upvalues);
     virtual ~LoxFunction() override = default;
 
     virtual int arity() override;
-    virtual Value call(Interpreter*, std::list<Value>&) override;
+    virtual Value call(Interpreter*, size_t argc) override;
+    virtual LoxFunction* asFunction() override {return this;}
+
+    Function* function() const {return declaration;}
+    const Upvalues& captures() const {return upvalues;}
 
 private:
     Function* declaration;
-    std::shared_ptr<Environment> closure;
+    // Just the variables the body uses from enclosing functions
+    Upvalues upvalues;
 
 };
 
@@ -0,0 +1,90 @@
+#ifndef LOX_STRING_HPP
+#define LOX_STRING_HPP
+
+#include "object.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace Lox {
+
+// The characters of a string value, allocated in one piece right behind the
+// header. Strings never change once made, so Values share them freely and
+// copying one never copies characters. The length is stored and the hash
+// is worked out the first time anything asks for it.
+//
+// A long concatenation starts out as a rope node holding its two halves
+// and is flattened into a buffer of its own the first time its characters
+// are needed, so a string built from N pieces costs O(N) rather than
+// O(N^2). Only the length is known without flattening.
+//
+// Equal strings are told apart from unequal ones of the same length through
+// the StringTable: each string remembers its interned twin, looked up the
+// first time it is compared, and after that a comparison is a pointer
+// compare.
+class LoxString : public Object {
+public:
+    // Shorter results are copied right away
+    static constexpr size_t ROPE_MINIMUM = 64;
+
+    static LoxString* make(std::string_view chars);
+    // May return one of the operands when the other is empty
+    static LoxString* concatenate(LoxString* left, LoxString* right);
+    // Only once the last reference is gone
+    static void free(LoxString*);
+
+    LoxString(const LoxString&) = delete;
+    LoxString& operator=(const LoxString&) = delete;
+
+    size_t length() const {return _length;}
+    const char* chars() const {
+        if (_chars == nullptr) flatten();
+        return _chars;
+    }
+    std::string_view view() const {return std::string_view{chars(), _length};}
+    uint32_t hash() const {return _hashed ? _hash : computeHash();}
+    static uint32_t hashOf(std::string_view chars);
+
+    // Cheap rejections first; the hashes are only compared if both are known
+    bool equals(const LoxString& other) const {
+        if (this == &other) return true;
+        if (_length != other._length) return false;
+        if (_hashed && other._hashed && _hash != other._hash) return false;
+        return interned() == other.interned();
+    }
+    // The string in the StringTable with the same characters
+    const LoxString* interned() const {
+        return _interned != nullptr ? _interned : intern();
+    }
+
+private:
+    explicit LoxString(size_t length) : _length{length}
+    {}
+
+    static LoxString* allocate(size_t length);
+    char* buffer() {return reinterpret_cast<char*>(this + 1);}
+    void flatten() const;
+    uint32_t computeHash() const;
+    const LoxString* intern() const;
+
+    friend class StringTable;
+
+    size_t _length;
+    // The trailing buffer, a flattened rope's own one, or null for a rope
+    // that has not been flattened yet
+    mutable const char* _chars = nullptr;
+    // A rope's halves, released once it is flattened
+    mutable LoxString* _left = nullptr;
+    mutable LoxString* _right = nullptr;
+    // Null until looked up, then this string if it is the one in the table
+    // or else a reference to the one that is
+    mutable LoxString* _interned = nullptr;
+    mutable uint32_t _hash = 0;
+    mutable bool _hashed = false;
+};
+
+} // Lox namespace
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef OBJECT_HPP
+#define OBJECT_HPP
+
+#include <cstdint>
+
+namespace Lox {
+
+// Base of everything a Value can point to. The object counts the Values
+// referring to it itself, so that a reference fits in a Value's 8 bytes.
+// Values are only ever touched by the interpreter's thread, so the count
+// is a plain integer.
+class Object {
+public:
+    uint32_t refs = 0;
+};
+
+} // Lox namespace
+
+#endif
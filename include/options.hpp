@@ -0,0 +1,48 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include "streaming_scanner.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace Lox {
+
+// Which of the two ways to run a program
+enum class Engine {
+    TREE,
+    VM,
+    CLOSURE
+};
+
+// Command line switches. Everything defaults to the plain behaviour.
+class Options {
+public:
+    // Returns false for anything that isn't a known option
+    bool parse(const std::string& arg);
+
+    static std::string usage();
+
+    // --stream[=WINDOW_BYTES]: scan scripts in fixed-size windows
+    bool stream = false;
+    size_t streamWindow = StreamingScanner::DEFAULT_WINDOW_SIZE;
+    // --parallel-scan[=THREADS]: tokenize large scripts on several threads
+    unsigned scanThreads = 1;
+    // --lazy[=check]: only brace-match top-level function bodies, parse and
+    // resolve them on their first call. With "check" the bodies are still
+    // parsed up front for their syntax errors, then thrown away.
+    bool lazy = false;
+    bool lazyCheck = false;
+    // --engine=tree|vm|closure: walk the syntax tree, compile it to bytecode
+    // for the VM, or lower it to pre-bound function objects
+    Engine engine = Engine::TREE;
+    // --jit=on|off|check: compile hot numeric functions of the tree-walker
+    // to machine code, see Jit. Checking also interprets every compiled
+    // call and reports results that differ. Off unless asked for.
+    bool jit = false;
+    bool jitCheck = false;
+};
+
+} // Lox namespace
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef PARALLEL_SCANNER_HPP
+#define PARALLEL_SCANNER_HPP
+
+#include "compact_token.hpp"
+#include "source_buffer.hpp"
+#include "token_source.hpp"
+#include "scan_error.hpp"
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Lox {
+
+// Tokenizes a large script on several threads. A quick pre-pass finds
+// newlines that are outside string literals and comments; the source is cut
+// there into chunks that are scanned independently and then stitched back
+// into exactly the stream the serial Scanner produces.
+class ParallelScanner : public TokenSource {
+public:
+    // Chunks smaller than this aren't worth a task
+    static constexpr size_t MINIMUM_CHUNK_SIZE = 256 * 1024;
+
+    ParallelScanner(std::shared_ptr<const SourceBuffer> source, unsigned threads, 
+                    size_t minimumChunkSize = MINIMUM_CHUNK_SIZE);
+    virtual ~ParallelScanner() override = default;
+
+    // Scan everything and report all errors
+    std::vector<CompactToken> scanCompactTokens();
+
+    // Pull mode: the whole source is scanned on the first call, and errors are
+    // reported as the tokens they precede are handed out, just like Scanner
+    virtual CompactToken next() override;
+    virtual std::string_view lexeme(const CompactToken& token) const override {
+        return token.lexeme(_source->view());
+    }
+    virtual std::shared_ptr<const SourceBuffer> buffer() const override {return _source;}
+
+    // Offsets where chunks may start: just after a newline that is not inside
+    // a string or a comment, as close after each of `chunks`-1 evenly spaced
+    // targets as possible. Always starts with 0.
+    static std::vector<size_t> splitPoints(std::string_view source, size_t chunks);
+
+private:
+    void scan();
+
+    std::shared_ptr<const SourceBuffer> _source;
+    unsigned _threads;
+    size_t _minimumChunkSize;
+
+    bool _scanned = false;
+    std::vector<CompactToken> _tokens;
+    std::vector<ScanError> _errors;
+    size_t _nextToken = 0;
+    size_t _nextError = 0;
+};
+
+} // Lox namespace
+
+#endif
@@ -4,67 +4,138 @@
 #include "lox.hpp"
 #include "token_type.hpp"
 #include "token.hpp"
+#include "compact_token.hpp"
+#include "token_source.hpp"
 #include "expr.hpp"
 #include "stmt.hpp"
+#include "program.hpp"
+#include "arena.hpp"
 #include "errors.hpp"
 
+#include <array>
+#include <memory>
 #include <vector>
-#include <list>
 #include <string>
+#include <string_view>
 
 namespace Lox {
 
 class Parser {
 public:
-    Parser(const std::list<Token>& t);
-    Parser(const std::vector<Token>& t);
+    // Tokens are pulled from the source as the parser needs them
+    explicit Parser(TokenSource& source);
 
-    std::vector<std::unique_ptr<Stmt>> parse();
+    std::unique_ptr<Program> parse();
+
+    // Only brace-match the bodies of top-level functions and leave them to
+    // parseDeferred(). Needs a source that keeps its buffer. With
+    // `checkSyntax` the bodies are parsed anyway to report syntax errors
+    // early, but the result is thrown away.
+    void deferBodies(bool checkSyntax);
+    // Parse a deferred body. The parser must be reading exactly the range
+    // recorded in function->deferred.
+    void parseDeferred(Function* function);
 
 private:
     static int MAXIMUM_FUNCTION_ARGS;
+    // Absolute index of the token being looked at
     int current = 0;
-    std::vector<Token> tokens;
+    TokenSource& _source;
+    // The most recent tokens pulled from the source, indexed by absolute
+    // index modulo the ring size. Only previous() and peek() are ever read.
+    std::array<CompactToken, TokenSource::LOOKAHEAD> _ring;
+    int _pulled = 0;
+
+    // The program being built. Child lists are collected on the scratch
+    // stacks below and copied into its arena once complete.
+    Program* _program = nullptr;
+    std::vector<Stmt*> _statements;
+    std::vector<Expr*> _arguments;
+    std::vector<Parameter> _parameters;
+
+    bool _deferBodies = false;
+    bool _checkDeferred = false;
+    // Block nesting; only functions declared at depth 0 are deferred
+    int _depth = 0;
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        return _program->arena.make<T>(std::forward<Args>(args)...);
+    }
 
     // Statement handling
-    std::unique_ptr<Stmt> statement();
-    std::unique_ptr<Stmt> printStatement();
-    std::unique_ptr<Stmt> returnStatement();
-    std::unique_ptr<Stmt> expressionStatement();
-    std::unique_ptr<Stmt> ifStatement();
-    std::unique_ptr<Stmt> whileStatement();
-    std::unique_ptr<Stmt> forStatement();
-    std::list<std::unique_ptr<Stmt>> block();
-    std::unique_ptr<Stmt> declaration();
-    std::unique_ptr<Stmt> function(const std::string&);
-    std::unique_ptr<Stmt> varDeclaration();
-
-    // Expression handling
-    std::unique_ptr<Expr> expression();
-    std::unique_ptr<Expr> assignment();
-    std::unique_ptr<Expr> or_expression();
-    std::unique_ptr<Expr> and_expression();
-    std::unique_ptr<Expr> equality();
-    std::unique_ptr<Expr> comparison();
-    std::unique_ptr<Expr> term();
-    std::unique_ptr<Expr> factor();
-    std::unique_ptr<Expr> unary();
-    std::unique_ptr<Expr> primary();
-    std::unique_ptr<Expr> call();
-    std::unique_ptr<Expr> finishCall(std::unique_ptr<Expr>&);
+    Stmt* statement();
+    Stmt* printStatement();
+    Stmt* returnStatement();
+    Stmt* expressionStatement();
+    Stmt* ifStatement();
+    Stmt* whileStatement();
+    Stmt* forStatement();
+    ArenaArray<Stmt*> block();
+    Stmt* declaration();
+    Stmt* function(const std::string&);
+    Stmt* varDeclaration();
+    void skipBody();
+
+    // Expression handling. Expressions are parsed by precedence climbing:
+    // every token type has a rule saying how it starts an expression (prefix),
+    // how it continues one (infix) and how tightly an infix operator binds.
+    enum class Precedence {
+        NONE,
+        ASSIGNMENT, // =
+        OR,         // or
+        AND,        // and
+        EQUALITY,   // == !=
+        COMPARISON, // < > <= >=
+        TERM,       // + -
+        FACTOR,     // * /
+        UNARY,      // ! -
+        CALL,       // ()
+        PRIMARY
+    };
+
+    class ParseRule {
+    public:
+        Expr* (Parser::*prefix)();
+        Expr* (Parser::*infix)(Expr*);
+        Precedence precedence;
+    };
+
+    static constexpr size_t TOKEN_TYPES = static_cast<size_t>(TokenType::END) + 1;
+    static constexpr std::array<ParseRule, TOKEN_TYPES> makeRules();
+    static const ParseRule& rule(TokenType type);
+
+    Expr* expression();
+    Expr* parsePrecedence(Precedence precedence);
+
+    // Prefix rules, called with the first token already consumed
+    Expr* grouping();
+    Expr* literal();
+    Expr* variable();
+    Expr* unary();
+
+    // Infix rules, called with the operator already consumed
+    Expr* binary(Expr* left);
+    Expr* logical(Expr* left);
+    Expr* assignment(Expr* target);
+    Expr* finishCall(Expr* callee);
 
     // Error handling
-    Token consume(const TokenType& type, const std::string& message);
-    ParseError error(const Token& token, const std::string& message);
+    const CompactToken& consume(TokenType type, std::string_view message);
+    ParseError error(const CompactToken& token, std::string_view message);
     void synchronize();
 
-    // Utility methods
+    // Utility methods. Tokens are handed out by reference into the ring, so a
+    // caller that needs one after parsing further has to copy it (16 bytes)
+    // and anything that needs its text has to take it right away.
     bool match(std::initializer_list<TokenType> types);
-    bool check(const TokenType& type);
-    Token advance();
-    Token peek();
-    Token previous();
+    bool check(TokenType type);
+    const CompactToken& advance();
+    const CompactToken& peek();
+    const CompactToken& previous();
     bool isAtEnd();
+    const CompactToken& at(int index);
+    Token name(const CompactToken& token);
 
 };
 
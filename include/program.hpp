@@ -0,0 +1,33 @@
+#ifndef PROGRAM_HPP
+#define PROGRAM_HPP
+
+#include "arena.hpp"
+#include "stmt.hpp"
+#include "source_buffer.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace Lox {
+
+// A parsed script or REPL line. Every node of its syntax tree lives in the
+// arena, so dropping the program frees the whole tree in one go.
+class Program {
+public:
+    Arena arena;
+    ArenaArray<Stmt*> statements;
+    // There can be millions of top-level statements, so rather than being
+    // copied into the arena they stay where the parser collected them and
+    // `statements` points there
+    std::vector<Stmt*> topLevel;
+    // Stack and cell slots the locals of top-level blocks need, set by the
+    // resolver; see Function
+    int frameSize = 0;
+    int cells = 0;
+    // Kept while function bodies are waiting to be parsed from it
+    std::shared_ptr<const SourceBuffer> source;
+};
+
+} // Lox namespace
+
+#endif
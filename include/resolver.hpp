@@ -4,9 +4,11 @@
 #include "expr.hpp"
 #include "stmt.hpp"
 #include "interpreter.hpp"
+#include "program.hpp"
 #include "lox.hpp"
 
 #include <algorithm>
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <map>
@@ -22,44 +24,95 @@ enum class FunctionType {
     FUNCTION
 };
 
-class Resolver : public ExprVisitor<void>, public StmtVisitor<void>{
+// A local variable in one of the resolver's scopes
+class Local {
+public:
+    bool defined;
+    // Slot in the frame of the function declaring it, on the stack or, once
+    // captured, among its cells
+    int slot;
+    // Used from a nested function, so it has to outlive the call in a cell
+    bool captured;
+    // Where the declaration records which of the two once the scope ends
+    Storage* storage;
+};
+
+// A use of a local from its own function, settled once the local's scope
+// ends and it is known whether a closure captured it
+class Reference {
+public:
+    Local* local;
+    Storage* storage;
+};
+
+class Scope {
+public:
+    // Node based, so References can point into it. Keyed by the names'
+    // interned strings, so a lookup hashes a pointer.
+    std::unordered_map<const LoxString*,Local> locals;
+    std::vector<Reference> references;
+    // Index into the resolver's frames of the function the scope is in
+    int frame;
+    // First stack slot the scope hands out
+    int firstSlot;
+};
+
+// Slot allocation and captures for one function, or for the top level
+class Frame {
+public:
+    int next = 0;
+    int size = 0;
+    bool captured = false;
+    std::vector<Capture> upvalues;
+};
+
+class Resolver {
 public:
     explicit Resolver(Interpreter*);
 
-    void resolve(std::vector<std::unique_ptr<Stmt>>&);
-    void resolve(std::list<std::unique_ptr<Stmt>>&);
-
-    // ExprVisitor<void>
-    virtual void visitBinaryExpr(Binary*) override;
-    virtual void visitGroupingExpr(Grouping*) override;
-    virtual void visitUnaryExpr(Unary*) override;
-    virtual void visitLiteralExpr(Literal*) override;
-    virtual void visitVariableExpr(Variable*) override;
-    virtual void visitAssignExpr(Assign*) override;
-    virtual void visitLogicalExpr(Logical*) override;
-    virtual void visitCallExpr(Call*) override;
-
-    // StmtVisitor<void>
-    virtual void visitExpressionStmt(Expression*) override;
-    virtual void visitFunctionStmt(Function*) override;
-    virtual void visitReturnStmt(Return*) override;
-    virtual void visitVarStmt(Var*) override;
-    virtual void visitPrintStmt(Print*) override;
-    virtual void visitBlockStmt(Block*) override;
-    virtual void visitIfStmt(If*) override;
-    virtual void visitWhileStmt(While*) override;
+    void resolve(Program&);
+    // Resolve a top-level function whose body was parsed late
+    void resolveDeferred(Function*);
+
+    // Expr visitor
+    void visitBinaryExpr(Binary*);
+    void visitGroupingExpr(Grouping*);
+    void visitUnaryExpr(Unary*);
+    void visitLiteralExpr(Literal*);
+    void visitVariableExpr(Variable*);
+    void visitAssignExpr(Assign*);
+    void visitLogicalExpr(Logical*);
+    void visitCallExpr(Call*);
+
+    // Stmt visitor
+    void visitExpressionStmt(Expression*);
+    void visitFunctionStmt(Function*);
+    void visitReturnStmt(Return*);
+    void visitVarStmt(Var*);
+    void visitPrintStmt(Print*);
+    void visitBlockStmt(Block*);
+    void visitIfStmt(If*);
+    void visitWhileStmt(While*);
 
 private:
     Interpreter* interpreter;
-    std::vector<std::unordered_map<std::string,bool>> scopes;
+    // Locals get consecutive slots of their function's frame in the order
+    // they are declared; a block's slots are reused once it ends. A deque,
+    // so Locals stay put while inner scopes come and go.
+    std::deque<Scope> scopes;
+    std::vector<Frame> frames;
+    // Where the upvalue lists of the functions being resolved go
+    Arena* arena;
 
     FunctionType currentFunction;
 
-    void resolve(std::unique_ptr<Stmt>&);
-    void resolve(std::unique_ptr<Expr>&);
-    void resolveLocal(Expr*, const Token&);
+    void resolve(const ArenaArray<Stmt*>&);
+    void resolve(Stmt*);
+    void resolve(Expr*);
+    void resolveLocal(const Token&, Storage& storage, int& slot, Global*& global);
+    int resolveUpvalue(int frame, int owner, int slot);
     void resolveFunction(Function* function,const FunctionType&);
-    void declare(const Token&);
+    void declare(const Token&, Storage& storage, int& slot);
     void define(const Token&);
 
     void beginScope();
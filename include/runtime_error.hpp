@@ -11,11 +11,14 @@ namespace Lox {
 class RuntimeError : public Error {
 public:
 
-    RuntimeError(const Token& op, const std::string& what) : Error(what), op{op}
+    RuntimeError(const Token& op, const std::string& what) : Error(what), line{op.line}
+    {}
+    RuntimeError(int line, const std::string& what) : Error(what), line{line}
     {}
     virtual ~RuntimeError() override = default;
 
-    Token op;
+    // Source line the error is reported against
+    int line;
 };
 
 } // Lox namespace
@@ -0,0 +1,20 @@
+#ifndef SCAN_ERROR_HPP
+#define SCAN_ERROR_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace Lox {
+
+// An error found while scanning, remembered with the number of tokens that
+// came before it so it can be reported at the same point in the stream
+class ScanError {
+public:
+    size_t token;
+    int line;
+    std::string message;
+};
+
+} // Lox namespace
+
+#endif
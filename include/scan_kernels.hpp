@@ -0,0 +1,40 @@
+#ifndef SCAN_KERNELS_HPP
+#define SCAN_KERNELS_HPP
+
+namespace Lox {
+
+// Kernels that find the end of a run of "boring" characters for the scanner.
+// Each takes the first byte of the run and one past the last byte of the
+// source, and returns a pointer to the first byte that is not part of the run.
+// Kernels that may cross newlines add the number they skipped to *newlines.
+class ScanKernels {
+public:
+    // ' ', '\r', '\t' and '\n'
+    const char* (*whitespace)(const char* p, const char* end, int* newlines);
+    // Everything up to (not including) the next '\n', for comment bodies
+    const char* (*lineRest)(const char* p, const char* end);
+    // [A-Za-z0-9_]
+    const char* (*identifier)(const char* p, const char* end);
+    // Everything up to (not including) the next '"'
+    const char* (*stringBody)(const char* p, const char* end, int* newlines);
+
+    const char* name;
+};
+
+enum class KernelSet {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// The best kernel set this CPU supports, checked at runtime
+KernelSet bestKernelSet();
+bool kernelSetSupported(KernelSet);
+
+// The kernels the scanner currently uses. Defaults to bestKernelSet().
+const ScanKernels& scanKernels();
+void setScanKernels(KernelSet);
+
+} // Lox namespace
+
+#endif
@@ -3,23 +3,60 @@
 
 #include "token.hpp"
 #include "token_type.hpp"
+#include "compact_token.hpp"
+#include "source_buffer.hpp"
+#include "scan_kernels.hpp"
+#include "token_source.hpp"
+#include "scan_error.hpp"
 #include "lox.hpp"
 #include "value.hpp"
 
 #include <list>
-#include <variant>
-#include <unordered_map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace Lox {
 
-class Scanner {
+class Scanner : public TokenSource {
 public:
     Scanner() = default;
     Scanner(std::string& source);
-    ~Scanner() = default;
+    explicit Scanner(std::shared_ptr<const SourceBuffer> source);
+    // Scan text owned by the caller, which must outlive the scanner's tokens.
+    // Line numbers start at `line`.
+    Scanner(std::string_view source, int line);
+    virtual ~Scanner() override = default;
 
+    // Pull mode: scan just far enough to produce the next token
+    virtual CompactToken next() override;
+    virtual std::string_view lexeme(const CompactToken& token) const override {
+        return token.lexeme(_source);
+    }
+
+    // Compact mode: tokens are (type, offset, length, line) records into the
+    // scanner's source buffer. Nothing is copied or decoded.
+    std::vector<CompactToken> scanCompactTokens();
+    // Self-contained tokens with their own lexeme and decoded literal
     std::list<Token> scanTokens();
 
+    // Window mode: scan the complete tokens at the front of the source (no END
+    // token) and return the offset of the first byte that was not consumed.
+    // Unless `final` is set, a token that could still continue past the end
+    // of the source is left unscanned so it can be carried into the next
+    // window.
+    size_t scanPrefix(bool final);
+    std::vector<CompactToken>& tokens() {return _tokens;}
+    int line() const {return _line;}
+
+    // Keep errors instead of reporting them, for scanners that run off the
+    // main thread
+    void holdErrors() {_holdErrors = true;}
+    std::vector<ScanError>& errors() {return _errors;}
+
+    virtual std::shared_ptr<const SourceBuffer> buffer() const override {return _buffer;}
+
 private:
     void scanToken();
     bool isAtEnd();
@@ -27,19 +64,21 @@ private:
     char peek();
     char peekNext();
     void addToken(const TokenType&);
-    void addToken(const TokenType&, Value);
     bool match(char);
+    void skip(const char*);
+    void error(const std::string&);
+    void reportErrors();
     void string();
-    bool isDigit(char);
     void number();
-    bool isAlpha(char);
-    bool isAlphaNumeric(char);
     void identifier();
 
-    static std::unordered_map<std::string, TokenType> keywords;
-    
-    std::string _source;
-    std::list<Token> _tokens;
+    std::shared_ptr<const SourceBuffer> _buffer;
+    std::string_view _source;
+    std::vector<CompactToken> _tokens;
+    const ScanKernels* _kernels;
+    // Errors are held until the token they belong to is known to be complete
+    std::vector<ScanError> _errors;
+    bool _holdErrors = false;
 
     int _start = 0;
     int _current = 0;
@@ -49,4 +88,4 @@ private:
 
 } // Lox namespace
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,40 @@
+#ifndef SOURCE_BUFFER_HPP
+#define SOURCE_BUFFER_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Lox {
+
+// Immutable backing storage for one script. Compact tokens only record an
+// offset and a length into it, so it is shared (and kept alive) by everything
+// that may still need to look at lexemes.
+//
+// The bytes either live in an owned string or in a read-only file mapping.
+class SourceBuffer {
+public:
+    explicit SourceBuffer(std::string text);
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    ~SourceBuffer();
+
+    // Map a script read-only. Files that can't be mapped (pipes, empty files)
+    // are read into memory instead. Returns nullptr if the file can't be opened.
+    static std::shared_ptr<const SourceBuffer> fromFile(const std::string& path);
+
+    std::string_view view() const {return std::string_view{_data, _size};}
+    size_t size() const {return _size;}
+
+private:
+    SourceBuffer(const char* mapping, size_t size);
+
+    std::string _text;
+    const char* _data;
+    size_t _size;
+    bool _mapped = false;
+};
+
+} // Lox namespace
+
+#endif
@@ -2,8 +2,7 @@
 #define STMT_HPP
 
 #include "expr.hpp"
-
-#include <list>
+#include "arena.hpp"
 
 namespace Lox {
 
@@ -15,34 +14,47 @@ class Print;
 class Block;
 class If;
 class While;
-
-//==============================================================================
-// Statement visitor interface
-//==============================================================================
-template<typename T>
-class StmtVisitor {
-public:
-    virtual ~StmtVisitor(){}
-
-    virtual T visitExpressionStmt(Expression*) = 0;
-    virtual T visitFunctionStmt(Function*) = 0;
-    virtual T visitReturnStmt(Return*) = 0;
-    virtual T visitVarStmt(Var*) = 0;
-    virtual T visitPrintStmt(Print*) = 0;
-    virtual T visitBlockStmt(Block*) = 0;
-    virtual T visitIfStmt(If*) = 0;
-    virtual T visitWhileStmt(While*) = 0;
+class Program;
+class Global;
+class Chunk;
+class LoweredBody;
+class JitCode;
+
+// How a statement finished. A function body stops at the first statement
+// that does not complete normally; the value of a return is handed over by
+// the interpreter separately.
+enum class Completion : uint8_t {
+    NORMAL,
+    RETURN
 };
 
 //==============================================================================
 // Base statement (interface)
 //==============================================================================
+enum class StmtKind : uint8_t {
+    EXPRESSION,
+    FUNCTION,
+    RETURN,
+    VAR,
+    PRINT,
+    BLOCK,
+    IF,
+    WHILE
+};
+
+// Arena resident and dispatched on its kind like Expr, see there
 class Stmt {
 public:
-    virtual ~Stmt(){};
+    ~Stmt() = default;
+
+    template<typename Visitor>
+    auto accept(Visitor* visitor);
 
-    virtual void accept(StmtVisitor<void>*) = 0;
+    const StmtKind kind;
 
+protected:
+    explicit Stmt(StmtKind kind) : kind{kind}
+    {}
 };
 
 //==============================================================================
@@ -50,122 +62,161 @@ public:
 //==============================================================================
 class Expression : public Stmt {
 public:
-    explicit Expression(std::unique_ptr<Expr>& expr) : expr{std::move(expr)}
+    explicit Expression(Expr* expr) : Stmt{StmtKind::EXPRESSION}, expr{expr}
     {}
-    virtual ~Expression() override = default;
-
-    virtual void accept(StmtVisitor<void>* visitor) override {
-        visitor->visitExpressionStmt(this);
-    }
 
-    std::unique_ptr<Expr> expr;
+    Expr* expr;
 };
 
 class Var : public Stmt {
 public: 
-    explicit Var(const Token& name, std::unique_ptr<Expr>& init) : name{name} ,initializer{std::move(init)}
+    Var(Token name, Expr* initializer) : Stmt{StmtKind::VAR}, name{std::move(name)}, initializer{initializer}
     {}
-    virtual ~Var() override = default;
-
-    virtual void accept(StmtVisitor<void>* visitor) override {
-        visitor->visitVarStmt(this);
-    }
 
     Token name;
-    std::unique_ptr<Expr> initializer;
+    Expr* initializer;
+    // Set by the resolver, see Variable
+    Storage storage = Storage::GLOBAL;
+    int slot = -1;
+    Global* global = nullptr;
 };
 
 class Print : public Stmt {
 public:
-    explicit Print(std::unique_ptr<Expr>& value) : value{std::move(value)}
+    explicit Print(Expr* value) : Stmt{StmtKind::PRINT}, value{value}
     {}
-    virtual ~Print() override = default;
 
-    virtual void accept(StmtVisitor<void>* visitor) override {
-        visitor->visitPrintStmt(this);
-    }
     
-    std::unique_ptr<Expr> value;
+    Expr* value;
 };
 
 class Block : public Stmt {
 public:
-    explicit Block(std::list<std::unique_ptr<Stmt>>&& statements) : statements{std::move(statements)} 
+    explicit Block(ArenaArray<Stmt*> statements) : Stmt{StmtKind::BLOCK}, statements{statements}
     {}
-    virtual ~Block() override = default;
-
-    virtual void accept(StmtVisitor<void>* visitor) override {
-        visitor->visitBlockStmt(this);
-    }
 
-    std::list<std::unique_ptr<Stmt>> statements;
+    ArenaArray<Stmt*> statements;
 };
 
 class If : public Stmt {
 public: 
-    If(std::unique_ptr<Expr>& condition, std::unique_ptr<Stmt>& thenBranch, std::unique_ptr<Stmt>& elseBranch) :
-    condition{std::move(condition)}, thenBranch{std::move(thenBranch)}, elseBranch{std::move(elseBranch)}
+    If(Expr* condition, Stmt* thenBranch, Stmt* elseBranch) :
+    Stmt{StmtKind::IF}, condition{condition}, thenBranch{thenBranch}, elseBranch{elseBranch}
     {}
-    virtual ~If() override = default;
-
-    virtual void accept(StmtVisitor<void>* visitor) override {
-        visitor->visitIfStmt(this);
-    }
 
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<Stmt> thenBranch;
-    std::unique_ptr<Stmt> elseBranch;
+    Expr* condition;
+    Stmt* thenBranch;
+    Stmt* elseBranch;
 };
 
 class While : public Stmt {
 public:
-    While(std::unique_ptr<Expr>& expr, std::unique_ptr<Stmt>& body) 
-    : expr{std::move(expr)}, body{std::move(body)}
+    While(Expr* expr, Stmt* body)
+    : Stmt{StmtKind::WHILE}, expr{expr}, body{body}
     {}
-    virtual ~While(){};
 
-    void accept(StmtVisitor<void>* visitor) {
-        visitor->visitWhileStmt(this);
-    }
+    Expr* expr;
+    Stmt* body;
+};
 
-    std::unique_ptr<Expr> expr;
-    std::unique_ptr<Stmt> body;
+// Where to find a function body that has only been brace-matched so far
+class DeferredBody {
+public:
+    Program* program;
+    // From just after the opening brace through the closing one
+    uint32_t offset;
+    uint32_t length;
+    int line;
 };
 
-class Function : public Stmt {
+class Parameter {
 public:
-    explicit Function(const Token& name, std::list<Token>& params, std::list<std::unique_ptr<Stmt>>& body) 
-    : name{name}, params{params}, body{std::move(body)}
+    explicit Parameter(Token name) : name{std::move(name)}
     {}
-    virtual ~Function(){}
 
-    virtual void accept(StmtVisitor<void>* visitor) override {
-        visitor->visitFunctionStmt(this);
-    }
+    Token name;
+    // Set by the resolver. Arguments arrive in the first stack slots of the
+    // call's frame; a captured parameter is copied into a cell.
+    Storage storage = Storage::STACK;
+    int slot = -1;
+};
+
+// A variable a closure captures, see Function::upvalues
+class Capture {
+public:
+    // Whether it is a cell of the frame the closure is created in, or one
+    // of the enclosing closure's own upvalues
+    bool local;
+    int index;
+};
+
+class Function : public Stmt {
+public:
+    Function(Token name, ArenaArray<Parameter> params, ArenaArray<Stmt*> body)
+    : Stmt{StmtKind::FUNCTION}, name{std::move(name)}, params{params}, body{body}
+    {}
 
     Token name;
-    std::list<Token> params;
-    std::list<std::unique_ptr<Stmt>> body;
+    ArenaArray<Parameter> params;
+    ArenaArray<Stmt*> body;
+    // Set until the body has been parsed and resolved, see Lox::compileDeferred
+    DeferredBody* deferred = nullptr;
+    // Where the function's name is stored, see Variable
+    Storage storage = Storage::GLOBAL;
+    int slot = -1;
+    Global* global = nullptr;
+    // Stack slots a call needs: parameters first, then the body's locals,
+    // with sibling blocks sharing theirs
+    int frameSize = 0;
+    // Cell slots a call needs. Captured locals keep their stack slot number,
+    // so this is either frameSize or, when nothing is captured, zero.
+    int cells = 0;
+    // Exactly the variables the body uses from enclosing functions, set by
+    // the resolver. Creating the closure copies their cells out of the
+    // running frame, and the body reads them in O(1) by index.
+    ArenaArray<Capture> upvalues;
+    // The body's bytecode, set by the Compiler under --engine=vm
+    Chunk* code = nullptr;
+    // The body as function objects, set by the ClosureEngine under
+    // --engine=closure
+    LoweredBody* lowered = nullptr;
+    // Calls so far and, once there were Jit::THRESHOLD of them, what the
+    // Jit compiled, under --jit
+    uint32_t calls = 0;
+    JitCode* jit = nullptr;
 
 };
 
 class Return : public Stmt {
 public:
 
-    explicit Return(const Token& keyword, std::unique_ptr<Expr>& value) 
-    : keyword{keyword}, value{std::move(value)}
+    Return(int line, Expr* value)
+    : Stmt{StmtKind::RETURN}, line{line}, value{value}
     {}
-    virtual ~Return(){}
 
-    virtual void accept(StmtVisitor<void>* visitor) override {
-        visitor->visitReturnStmt(this);
-    }
-
-    Token keyword;
-    std::unique_ptr<Expr> value;
+    int line;
+    Expr* value;
 
 };
 
+//==============================================================================
+// Dispatch
+//==============================================================================
+template<typename Visitor>
+auto Stmt::accept(Visitor* visitor) {
+    switch (kind) {
+    case StmtKind::EXPRESSION: return visitor->visitExpressionStmt(static_cast<Expression*>(this));
+    case StmtKind::FUNCTION: return visitor->visitFunctionStmt(static_cast<Function*>(this));
+    case StmtKind::RETURN: return visitor->visitReturnStmt(static_cast<Return*>(this));
+    case StmtKind::VAR: return visitor->visitVarStmt(static_cast<Var*>(this));
+    case StmtKind::PRINT: return visitor->visitPrintStmt(static_cast<Print*>(this));
+    case StmtKind::BLOCK: return visitor->visitBlockStmt(static_cast<Block*>(this));
+    case StmtKind::IF: return visitor->visitIfStmt(static_cast<If*>(this));
+    case StmtKind::WHILE: break;
+    }
+    return visitor->visitWhileStmt(static_cast<While*>(this));
+}
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef STREAMING_SCANNER_HPP
+#define STREAMING_SCANNER_HPP
+
+#include "compact_token.hpp"
+#include "scan_error.hpp"
+#include "token_source.hpp"
+
+#include <array>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace Lox {
+
+// Scans a script in fixed-size windows so the whole text never has to be in
+// memory at once. A token cut by the end of a window is carried over to the
+// front of the next one.
+//
+// Tokens are handed out one at a time. The lexemes of the last few tokens are
+// copied into a small ring of slots (the token's offset names its slot), so
+// memory stays at one window plus the parser's lookahead. Scan errors are
+// held and reported as the tokens they precede are handed out, just like
+// Scanner.
+class StreamingScanner : public TokenSource {
+public:
+    StreamingScanner(std::istream& input, size_t windowSize);
+    virtual ~StreamingScanner() override = default;
+
+    virtual CompactToken next() override;
+    virtual std::string_view lexeme(const CompactToken& token) const override {
+        return _lexemes[token.offset];
+    }
+
+    static constexpr size_t DEFAULT_WINDOW_SIZE = 1 << 20;
+
+private:
+    bool readWindow();
+    void scanWindow();
+
+    std::istream& _input;
+    size_t _windowSize;
+    std::string _window;
+    bool _last = false;
+    int _line = 1;
+
+    // Complete tokens of the current window, offsets relative to the window
+    std::vector<CompactToken> _pending;
+    size_t _nextPending = 0;
+    size_t _consumed = 0;
+    // Errors of the current window, positioned by pending token
+    std::vector<ScanError> _errors;
+    size_t _nextError = 0;
+
+    std::array<std::string, 2 * LOOKAHEAD> _lexemes;
+    size_t _handedOut = 0;
+};
+
+} // Lox namespace
+
+#endif
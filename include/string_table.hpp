@@ -0,0 +1,54 @@
+#ifndef STRING_TABLE_HPP
+#define STRING_TABLE_HPP
+
+#include "lox_string.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Lox {
+
+// The process-wide set of interned strings: at most one per sequence of
+// characters, so two interned strings are equal exactly when they are the
+// same object. Literals and names are interned as they are decoded,
+// strings made at runtime only once something compares them.
+//
+// Entries are weak. The table holds no reference; a string leaves it when
+// it is freed. Open addressing with linear probing; each slot keeps a copy
+// of its string's hash, so a probe only touches the string on a match.
+class StringTable {
+public:
+    // The interned string with these characters, made the first time
+    static LoxString* intern(std::string_view chars);
+    // The interned string equal to `string`, which becomes it if there is none
+    static LoxString* intern(LoxString* string);
+    // Only from LoxString::free
+    static void remove(LoxString* string);
+
+    static size_t size() {return table()._count;}
+
+private:
+    class Entry {
+    public:
+        LoxString* string;
+        uint32_t hash;
+    };
+
+    static StringTable& table();
+
+    // Index of the entry with these characters, or of the empty slot it
+    // would go into
+    size_t find(std::string_view chars, uint32_t hash) const;
+    void insert(LoxString* string);
+    void grow();
+
+    std::vector<Entry> _entries;
+    size_t _count = 0;
+    size_t _tombstones = 0;
+};
+
+} // Lox namespace
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Lox {
+
+// A fixed set of worker threads pulling tasks off one queue
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    // Block until every submitted task has finished
+    void wait();
+
+    size_t size() const {return _workers.size();}
+
+private:
+    void work();
+
+    std::vector<std::thread> _workers;
+    std::queue<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _available;
+    std::condition_variable _finished;
+    size_t _running = 0;
+    bool _stopping = false;
+};
+
+} // Lox namespace
+
+#endif
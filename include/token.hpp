@@ -6,6 +6,7 @@
 #include "token_type.hpp"
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <variant>
 
@@ -21,16 +22,26 @@ public:
     //     int line
     // ) : type{type}, lexeme{lexeme}, literal{literal}, line{line}
     // {}
-    Token(const TokenType& type,const std::string& lexeme, Value literal, int line)
-    : type{type}, lexeme{lexeme}, literal{literal}, line{line}
+    Token(const TokenType& type, std::string lexeme, Value literal, int line)
+    : type{type}, lexeme{std::move(lexeme)}, line{line}, literal{std::move(literal)}
     {}
 
+    Token(const Token&) = default;
+    Token(Token&&) = default;
+    Token& operator=(const Token&) = default;
+    Token& operator=(Token&&) = default;
     ~Token() = default;
 
     // We can print out info about tokens in a fairly elegant way by making it
     // work with the C++ stream objects
     friend std::ostream& operator<<(std::ostream& stream, const Token& token) {
-        return stream << token.lexeme << std::endl;
+        return stream << token.text() << std::endl;
+    }
+
+    // What the token was scanned from. An identifier keeps its text only in
+    // its interned name, so naming one costs a single allocation.
+    std::string_view text() const {
+        return type == TokenType::IDENTIFIER ? literal.asString() : std::string_view{lexeme};
     }
 
     TokenType type;
@@ -38,7 +49,8 @@ public:
     int line;
     // An alleged equivalent to the Java Object type for storing literals for Lox.
     // Definitely not the most elegant solution but it allows for the two "base" 
-    // types of literal as well as a null equivalent (monostate)
+    // types of literal as well as a null equivalent (nil). An identifier's is
+    // its interned name, and its lexeme is left empty.
     Value literal;
     // std::variant<
     //     double,
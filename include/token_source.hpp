@@ -0,0 +1,41 @@
+#ifndef TOKEN_SOURCE_HPP
+#define TOKEN_SOURCE_HPP
+
+#include "compact_token.hpp"
+#include "source_buffer.hpp"
+#include "token.hpp"
+
+#include <memory>
+#include <string_view>
+
+namespace Lox {
+
+// Something the parser can pull compact tokens from, one at a time. Once the
+// input is exhausted next() keeps returning END.
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+
+    virtual CompactToken next() = 0;
+    // The text of a token handed out recently. Sources are only required to
+    // keep the lexemes of the last LOOKAHEAD tokens available.
+    virtual std::string_view lexeme(const CompactToken&) const = 0;
+
+    Token materialize(const CompactToken& token) const {
+        return token.withLexeme(lexeme(token));
+    }
+
+    Value literal(const CompactToken& token) const {
+        return CompactToken::decodeLiteral(token.type, lexeme(token));
+    }
+
+    // The buffer token offsets point into, for sources that keep all of it
+    // in memory. Parts of it can then be scanned again later.
+    virtual std::shared_ptr<const SourceBuffer> buffer() const {return nullptr;}
+
+    static constexpr size_t LOOKAHEAD = 4;
+};
+
+} // Lox namespace
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef TRANSPILER_HPP
+#define TRANSPILER_HPP
+
+#include "expr.hpp"
+#include "stmt.hpp"
+#include "program.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Lox {
+
+// Turns a resolved program into a C++ translation unit for loxc, to be
+// compiled and linked against lox_core. Every Lox function becomes a C++
+// function, and every stack slot of its frame a local Value, so the C++
+// compiler keeps what it can in registers; captured variables stay in
+// Cells and globals in a GlobalTable, exactly as the Interpreter has them.
+// Each operation is a call into Aot, which checks its operands the way the
+// Interpreter does, so a transpiled script prints and fails the same.
+class Transpiler {
+public:
+    Transpiler() = default;
+
+    // `source` only goes into a comment at the top
+    std::string transpile(Program&, const std::string& source);
+
+    // Expr visitor, leaving C++ for the value in _result
+    void visitBinaryExpr(Binary*);
+    void visitGroupingExpr(Grouping*);
+    void visitUnaryExpr(Unary*);
+    void visitLiteralExpr(Literal*);
+    void visitVariableExpr(Variable*);
+    void visitAssignExpr(Assign*);
+    void visitLogicalExpr(Logical*);
+    void visitCallExpr(Call*);
+
+    // Stmt visitor
+    void visitExpressionStmt(Expression*);
+    void visitFunctionStmt(Function*);
+    void visitReturnStmt(Return*);
+    void visitVarStmt(Var*);
+    void visitPrintStmt(Print*);
+    void visitBlockStmt(Block*);
+    void visitIfStmt(If*);
+    void visitWhileStmt(While*);
+
+private:
+    // The C++ function being written: its statements so far, and which of
+    // its slots they used
+    std::string _code;
+    int _indent = 0;
+    bool _inFunction = false;
+    std::vector<bool> _stackUsed;
+    std::vector<bool> _cellsUsed;
+
+    // An expression's value. Stable unless it names a variable that code
+    // emitted later could assign.
+    std::string _result;
+    bool _stable = true;
+    int _temps = 0;
+
+    // Finished C++ functions, and what every one of them refers to
+    std::vector<std::string> _prototypes;
+    std::vector<std::string> _definitions;
+    std::vector<std::string> _constants;
+    std::unordered_map<std::string, size_t> _constantIds;
+    std::vector<Global*> _globals;
+    std::unordered_map<Global*, size_t> _globalIds;
+
+    std::string evaluate(Expr*);
+    // `code` in a temporary, unless it is stable already
+    std::string hold(const std::string& code, bool stable);
+    std::string temp(const std::string& code);
+    void emit(const std::string& line);
+    void emitBranch(Stmt*);
+    void emitBody(const ArenaArray<Stmt*>&);
+    void define(Storage, int slot, Global*, const std::string& value);
+
+    std::string function(Function*);
+    std::string frame(int frameSize, int cells, const ArenaArray<Parameter>* params);
+    std::string stackSlot(int slot);
+    std::string cellSlot(int slot);
+    std::string global(Global*);
+    std::string constant(std::string_view);
+    std::string operation(const char* helper, int line, const std::string& left, const std::string& right);
+
+    static bool mayAssign(Expr*);
+    static std::string literal(const Value&);
+    static std::string quote(std::string_view);
+};
+
+} // Lox namespace
+
+#endif
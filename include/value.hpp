@@ -1,35 +1,87 @@
 #ifndef VALUE_HPP
 #define VALUE_HPP
 
-#include <list>
+#include "object.hpp"
+#include "lox_string.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include <variant>
-#include <memory>
+#include <string_view>
 
 namespace Lox {
 
 class LoxCallable;
 
+// A Lox value NaN-boxed into 64 bits. Any bit pattern without all of QNAN's
+// bits set is a double. nil, false and true are three such NaNs,
+// and heap objects are a NaN with the sign bit set, carrying the pointer in
+// the low bits and what it points to in the three alignment bits.
+//
+// Lox has one number type, but integral numbers that fit in 32 bits are
+// kept as integers, in the low half of another NaN. Arithmetic on two of
+// them stays integral unless the result would not fit or would be -0, in
+// which case it is computed on doubles as it always was. Either way a
+// number compares, prints and computes exactly as the double would.
 class Value {
 public:
-    Value();
-    explicit Value(const double& v);
-    explicit Value(const bool& v);
-    explicit Value(const std::string& v);
-    explicit Value(const std::monostate& v);
-    explicit Value(std::shared_ptr<LoxCallable>& v);
-    Value(const Value&) = default;
-    Value(
-        const std::variant<double, 
-            bool,
-            std::string,
-            std::monostate, 
-            std::shared_ptr<LoxCallable>
-            >& v
-        );
+    Value() : _bits{TAG_NIL} {}
+    explicit Value(double v) {std::memcpy(&_bits, &v, sizeof v);}
+    explicit Value(int32_t v) : _bits{TAG_INT | static_cast<uint32_t>(v)} {}
+    explicit Value(bool v) : _bits{v ? TAG_TRUE : TAG_FALSE} {}
+    explicit Value(std::string_view v) : Value{LoxString::make(v), STRING} {}
+    explicit Value(const std::string& v) : Value{std::string_view{v}} {}
+    // Or it would be taken for a bool
+    explicit Value(const char* v) : Value{std::string_view{v}} {}
+    explicit Value(LoxString* v) : Value{v, STRING} {}
+    // The value shares the callable with every other one holding it
+    explicit Value(LoxCallable* v);
+
+    Value(const Value& other) : _bits{other._bits} {retain();}
+    Value(Value&& other) noexcept : _bits{other._bits} {other._bits = TAG_NIL;}
+    Value& operator=(const Value& other) {
+        other.retain();
+        release();
+        _bits = other._bits;
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            release();
+            _bits = other._bits;
+            other._bits = TAG_NIL;
+        }
+        return *this;
+    }
+    ~Value() {release();}
+
+    // Each is a single compare against the tag bits, but for isNumber
+    bool isNumber() const {return isDouble() || isInt();}
+    bool isDouble() const {return (_bits & QNAN) != QNAN;}
+    bool isInt() const {return (_bits & INT_MASK) == TAG_INT;}
+    bool isNil() const {return _bits == TAG_NIL;}
+    bool isBool() const {return (_bits | 1) == TAG_TRUE;}
+    bool isObject() const {return (_bits & OBJECT) == OBJECT;}
+    bool isString() const {return (_bits & TAG_MASK) == (OBJECT | STRING);}
+    bool isCallable() const {return (_bits & TAG_MASK) == (OBJECT | CALLABLE);}
 
+    double asNumber() const {return isInt() ? asInt() : asDouble();}
+    double asDouble() const {
+        double v;
+        std::memcpy(&v, &_bits, sizeof v);
+        return v;
+    }
+    int32_t asInt() const {return static_cast<int32_t>(static_cast<uint32_t>(_bits));}
+    // An integer if `v` is one that fits, a double otherwise
+    static Value number(double v);
+    bool asBool() const {return _bits == TAG_TRUE;}
+    const LoxString* asLoxString() const {return static_cast<LoxString*>(object());}
+    std::string_view asString() const {return asLoxString()->view();}
+    LoxCallable* asCallable() const;
 
     // Arithmetic
+    Value operator-() const;
     Value operator+(const Value&) const;
     Value operator-(const Value&) const;
     Value operator*(const Value&) const;
@@ -43,16 +95,123 @@ public:
     bool operator==(const Value&) const;
     bool operator!=(const Value&) const;
 
-    std::variant<
-        double,
-        bool,
-        std::string,
-        std::monostate,
-        std::shared_ptr<LoxCallable>
-        > item;
-    
+private:
+    static constexpr uint64_t QNAN = 0x7ffc000000000000;
+    static constexpr uint64_t SIGN = 0x8000000000000000;
+    static constexpr uint64_t TAG_NIL = QNAN | 1;
+    static constexpr uint64_t TAG_FALSE = QNAN | 2;
+    static constexpr uint64_t TAG_TRUE = QNAN | 3;
+    // Integers have bit 48 set as well and the value in the low 32 bits
+    static constexpr uint64_t TAG_INT = QNAN | (uint64_t{1} << 48);
+    static constexpr uint64_t INT_MASK = 0xffff000000000000;
+    static constexpr uint64_t OBJECT = SIGN | QNAN;
+    // Object kinds, kept in the pointer's alignment bits
+    static constexpr uint64_t STRING = 1;
+    static constexpr uint64_t CALLABLE = 2;
+    static constexpr uint64_t TAG_MASK = OBJECT | 7;
+
+    Value(Object* object, uint64_t kind)
+    : _bits{OBJECT | reinterpret_cast<uintptr_t>(object) | kind} {
+        object->refs++;
+    }
+
+    Object* object() const {return reinterpret_cast<Object*>(_bits & ~TAG_MASK);}
+    void retain() const {if (isObject()) object()->refs++;}
+    void release() {if (isObject() && --object()->refs == 0) destroy();}
+    void destroy();
+    // What the inlined cases leave: integers that overflow, an integer and
+    // a double, and for add, strings
+    Value add(const Value&) const;
+    Value subtract(const Value&) const;
+    Value multiply(const Value&) const;
+    Value concatenate(const Value&) const;
+
+    uint64_t _bits;
 };
 
+//==============================================================================
+// The number cases are inlined, everything else goes out of line
+//==============================================================================
+inline Value Value::number(double v) {
+    if (v >= INT32_MIN && v <= INT32_MAX) {
+        auto i = static_cast<int32_t>(v);
+        if (i == v && (i != 0 || !std::signbit(v))) return Value{i};
+    }
+    return Value{v};
+}
+
+// -0 and -INT32_MIN are doubles
+inline Value Value::operator-() const {
+    if (isInt() && asInt() != 0 && asInt() != INT32_MIN) return Value{-asInt()};
+    return Value{-asNumber()};
+}
+
+inline Value Value::operator+(const Value& rhs) const {
+    int32_t sum;
+    if (isInt() && rhs.isInt() && !__builtin_add_overflow(asInt(), rhs.asInt(), &sum)) {
+        return Value{sum};
+    }
+    if (isDouble() && rhs.isDouble()) return Value{asDouble() + rhs.asDouble()};
+    return add(rhs);
+}
+
+inline Value Value::operator-(const Value& rhs) const {
+    int32_t difference;
+    if (isInt() && rhs.isInt() && !__builtin_sub_overflow(asInt(), rhs.asInt(), &difference)) {
+        return Value{difference};
+    }
+    if (isDouble() && rhs.isDouble()) return Value{asDouble() - rhs.asDouble()};
+    return subtract(rhs);
+}
+
+// A zero product with a negative factor is -0, left to the doubles
+inline Value Value::operator*(const Value& rhs) const {
+    int32_t product;
+    if (isInt() && rhs.isInt() && !__builtin_mul_overflow(asInt(), rhs.asInt(), &product) &&
+        (product != 0 || (asInt() | rhs.asInt()) >= 0)) {
+        return Value{product};
+    }
+    if (isDouble() && rhs.isDouble()) return Value{asDouble() * rhs.asDouble()};
+    return multiply(rhs);
+}
+
+inline Value Value::operator/(const Value& rhs) const {
+    if (isNumber() && rhs.isNumber()) return Value{asNumber() / rhs.asNumber()};
+    return Value{};
+}
+
+inline bool Value::operator>(const Value& rhs) const {
+    if (isInt() && rhs.isInt()) return asInt() > rhs.asInt();
+    return isNumber() && rhs.isNumber() && asNumber() > rhs.asNumber();
+}
+
+inline bool Value::operator>=(const Value& rhs) const {
+    if (isInt() && rhs.isInt()) return asInt() >= rhs.asInt();
+    return isNumber() && rhs.isNumber() && asNumber() >= rhs.asNumber();
+}
+
+inline bool Value::operator<(const Value& rhs) const {
+    return rhs > (*this);
+}
+
+inline bool Value::operator<=(const Value& rhs) const {
+    return rhs >= (*this);
+}
+
+// Numbers compare as doubles, so NaN is not equal to itself and 0 equals -0.
+// Other identical bits are equal, except that functions have never compared
+// equal to anything; strings compare by content.
+inline bool Value::operator==(const Value& rhs) const {
+    if (isInt() && rhs.isInt()) return _bits == rhs._bits;
+    if (isNumber() && rhs.isNumber()) return asNumber() == rhs.asNumber();
+    if (_bits == rhs._bits) return !isCallable();
+    return isString() && rhs.isString() && asLoxString()->equals(*rhs.asLoxString());
+}
+
+inline bool Value::operator!=(const Value& rhs) const {
+    return !((*this) == rhs);
+}
+
 } // lox namespace
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,60 @@
+#ifndef VM_HPP
+#define VM_HPP
+
+#include "chunk.hpp"
+#include "cell.hpp"
+#include "program.hpp"
+#include "value.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace Lox {
+
+class Interpreter;
+
+// Runs programs compiled to bytecode, for --engine=vm. Frames are laid out
+// the way the tree-walker lays them out: a call's arguments and uncaptured
+// locals are consecutive slots of one value stack, with its temporaries on
+// top, and captured locals are cells on a stack of their own. Globals are
+// the interpreter's, so both engines agree on what the resolver bound.
+class VM {
+public:
+    static constexpr size_t STACK_SIZE = 1 << 18;
+    static constexpr size_t MAX_FRAMES = 1 << 15;
+
+    // Natives are called with `interpreter`, as the tree-walker calls them
+    explicit VM(Interpreter* interpreter);
+
+    void interpret(Program&);
+
+private:
+    class CallFrame {
+    public:
+        // Where the caller continues, saved while a callee runs
+        const uint8_t* ip;
+        Chunk* chunk;
+        Value* slots;
+        size_t cellBase;
+        // The running closure's captured variables, none at top level
+        const Upvalues* upvalues;
+    };
+
+    Interpreter* _interpreter;
+    // Allocated by the first program that runs
+    std::unique_ptr<Value[]> _stack;
+    std::unique_ptr<CallFrame[]> _frames;
+    size_t _frameCount;
+    Upvalues _cells;
+    // Top of the stack as last known outside run(), so that an error can
+    // release whatever the abandoned frames held
+    Value* _top;
+
+    void run();
+    Upvalues capture(Function*, const CallFrame&);
+    void compileLate(Function*);
+};
+
+} // Lox namespace
+
+#endif
@@ -0,0 +1,57 @@
+#include "./include/lox.hpp"
+#include "./include/transpiler.hpp"
+
+#include <fstream>
+#include <iostream>
+
+// loxc SCRIPT [-o OUTPUT]: write SCRIPT as a C++ translation unit that,
+// linked against lox_core, runs it as lox would
+int main(int argc, char** argv) {
+    std::string path;
+    std::string output;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (path.empty() && arg.rfind("-", 0) != 0) {
+            path = arg;
+        } else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        std::cout << "Usage: loxc script [-o output]" << std::endl;
+        return 64;
+    }
+
+    auto source = Lox::SourceBuffer::fromFile(path);
+    if (source == nullptr) {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        return 66;
+    }
+
+    // The same front end as lox
+    Lox::Scanner scanner{source};
+    Lox::Parser parser{scanner};
+    auto program = parser.parse();
+    if (Lox::Lox::hadError) return 65;
+    Lox::Interpreter interpreter{};
+    Lox::Resolver resolver{&interpreter};
+    resolver.resolve(*program);
+    if (Lox::Lox::hadError) return 65;
+
+    Lox::Transpiler transpiler{};
+    auto code = transpiler.transpile(*program, path);
+    if (output.empty()) {
+        std::cout << code;
+        return 0;
+    }
+    std::ofstream file(output, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << output << std::endl;
+        return 73;
+    }
+    file << code;
+    return 0;
+}
@@ -0,0 +1,14 @@
+#include "../include/aot_function.hpp"
+#include "../include/interpreter.hpp"
+
+namespace Lox {
+
+int AotFunction::arity() {
+    return params;
+}
+
+Value AotFunction::call(Interpreter* interpreter, size_t argc) {
+    return invoke(interpreter->arguments(argc), argc);
+}
+
+} // Lox namespace
@@ -0,0 +1,71 @@
+#include "../include/aot_runtime.hpp"
+#include "../include/interpreter.hpp"
+
+#include <iostream>
+
+namespace Lox {
+
+int Aot::run(void (*script)()) {
+    try {
+        script();
+    } catch (RuntimeError& error) {
+        // Everything printed so far comes before the error, as with lox
+        std::cout.flush();
+        Lox::runtimeError(error);
+    }
+    std::cout.flush();
+    return Lox::hadRuntimeError ? 70 : 0;
+}
+
+Global* Aot::global(std::string_view name) {
+    return interpreter().globals.intern(name);
+}
+
+void Aot::print(const Value& value) {
+    if (value.isString()) {
+        auto text = value.asString();
+        std::cout.write(text.data(), text.size()) << '\n';
+    } else {
+        std::cout << Interpreter::stringify(value) << '\n';
+    }
+}
+
+// Never destroyed: globals can hold values until the very end of the process
+Interpreter& Aot::interpreter() {
+    static auto* interpreter = new Interpreter{};
+    return *interpreter;
+}
+
+Value Aot::callNative(LoxCallable* callable, const Value* args, size_t argc) {
+    return interpreter().call(callable, args, argc);
+}
+
+void Aot::checkNumber(int line, const Value& v) {
+    if (v.isNumber()) return;
+    throw RuntimeError{line, "Operand must be a number."};
+}
+
+void Aot::checkNumbers(int line, const Value& l, const Value& r) {
+    if (l.isNumber() && r.isNumber()) return;
+    throw RuntimeError{line, "Operands must be double."};
+}
+
+void Aot::checkAddition(int line, const Value& l, const Value& r) {
+    if (l.isNumber() && r.isNumber()) return;
+    if (l.isString() && r.isString()) return;
+    throw RuntimeError{line, "Operands must be double or string."};
+}
+
+void Aot::undefinedVariable(int line, Global* global) {
+    throw RuntimeError{line, "Undefined variable '" + std::string{global->name.asString()} + "'."};
+}
+
+void Aot::undefinedAssignment(int line, Global* global) {
+    throw RuntimeError{line, "Undefined variable " + std::string{global->name.asString()} + "."};
+}
+
+void Aot::notCallable(int line) {
+    throw RuntimeError{line, "Can only call functions and classes."};
+}
+
+} // Lox namespace
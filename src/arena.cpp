@@ -0,0 +1,55 @@
+#include "../include/arena.hpp"
+
+#include <cstdlib>
+
+namespace Lox {
+
+//==============================================================================
+// Constructors
+//==============================================================================
+Arena::~Arena() {
+    // Newest first, so objects go before anything they were built from
+    for (auto* finalizer = _finalizers; finalizer != nullptr; finalizer = finalizer->next) {
+        finalizer->destroy(finalizer->objects, finalizer->count);
+    }
+    while (_blocks != nullptr) {
+        auto* next = _blocks->next;
+        std::free(_blocks);
+        _blocks = next;
+    }
+}
+
+//==============================================================================
+// Allocation
+//==============================================================================
+void* Arena::allocate(size_t size, size_t alignment) {
+    auto address = reinterpret_cast<uintptr_t>(_next);
+    auto aligned = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (_next == nullptr || aligned + size > reinterpret_cast<uintptr_t>(_limit)) {
+        grow(size + alignment);
+        address = reinterpret_cast<uintptr_t>(_next);
+        aligned = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    _next = reinterpret_cast<char*>(aligned + size);
+    _used += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void Arena::onRelease(void* objects, size_t count, void (*destroy)(void*, size_t)) {
+    auto* finalizer = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+    *finalizer = Finalizer{destroy, objects, count, _finalizers};
+    _finalizers = finalizer;
+}
+
+// Oversized requests get a block of their own
+void Arena::grow(size_t minimum) {
+    size_t size = sizeof(Block) + (minimum > BLOCK_SIZE ? minimum : BLOCK_SIZE);
+    auto* block = static_cast<Block*>(std::malloc(size));
+    if (block == nullptr) throw std::bad_alloc{};
+    *block = Block{_blocks, size};
+    _blocks = block;
+    _next = reinterpret_cast<char*>(block + 1);
+    _limit = reinterpret_cast<char*>(block) + size;
+}
+
+} // Lox namespace
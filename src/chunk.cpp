@@ -0,0 +1,16 @@
+#include "../include/chunk.hpp"
+
+namespace Lox {
+
+int Chunk::line(size_t offset) const {
+    // The last run starting at or before the offset
+    size_t low = 0, high = lines.size();
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (lines[middle].offset <= offset) low = middle;
+        else high = middle;
+    }
+    return lines.empty() ? 0 : lines[low].line;
+}
+
+} // Lox namespace
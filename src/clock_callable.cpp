@@ -4,7 +4,7 @@ namespace Lox {
 
 int ClockCallable::arity() {return 0;}
 
-Value ClockCallable::call(Interpreter* interpreter, std::list<Value>& args) {
+Value ClockCallable::call(Interpreter* interpreter, size_t argc) {
     using namespace std::chrono;
 
     // Grab ms since 1970 and cast to double
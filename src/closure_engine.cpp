@@ -0,0 +1,475 @@
+#include "../include/closure_engine.hpp"
+#include "../include/lox.hpp"
+
+namespace Lox {
+
+namespace {
+
+bool isTruthy(const Value& v) {
+    if (v.isNil()) return false;
+    if (v.isBool()) return v.asBool();
+    return true;
+}
+
+// Arithmetic only makes nil out of operands of the wrong type, as in the
+// tree-walker
+template<typename Op>
+ExprFn arithmetic(ExprFn left, ExprFn right, int line, const char* message, Op op) {
+    return [left = std::move(left), right = std::move(right), line, message, op](ClosureEngine& engine) {
+        const Value a = left(engine);
+        const Value b = right(engine);
+        Value result = op(a, b);
+        if (result.isNil()) throw RuntimeError{line, message};
+        return result;
+    };
+}
+
+// Two integers compare without a check
+template<typename Op>
+ExprFn comparison(ExprFn left, ExprFn right, int line, Op op) {
+    return [left = std::move(left), right = std::move(right), line, op](ClosureEngine& engine) {
+        const Value a = left(engine);
+        const Value b = right(engine);
+        if ((!a.isInt() || !b.isInt()) && (!a.isNumber() || !b.isNumber())) {
+            throw RuntimeError{line, "Operands must be double."};
+        }
+        return Value{op(a, b)};
+    };
+}
+
+} // anonymous namespace
+
+ClosureEngine::ClosureEngine(Interpreter* interpreter)
+: _interpreter{interpreter}, _arena{nullptr}, _expr{}, _stmt{}
+{}
+
+void ClosureEngine::interpret(Program& program) {
+    _arena = &program.arena;
+    auto statements = lower(program.statements);
+
+    _frame = 0;
+    _cellFrame = 0;
+    _upvalues = nullptr;
+    _stack.resize(program.frameSize);
+    _cells.resize(program.cells);
+    try {
+        for (auto& statement : statements) {
+            statement(*this);
+        }
+    } catch(RuntimeError& error) {
+        Lox::runtimeError(error);
+    }
+    // An error can leave any number of calls' frames behind
+    _stack.clear();
+    _cells.clear();
+}
+
+ExprFn ClosureEngine::lower(Expr* expr) {
+    expr->accept(this);
+    return std::move(_expr);
+}
+
+StmtFn ClosureEngine::lower(Stmt* stmt) {
+    stmt->accept(this);
+    return std::move(_stmt);
+}
+
+std::vector<StmtFn> ClosureEngine::lower(const ArenaArray<Stmt*>& statements) {
+    std::vector<StmtFn> lowered{};
+    lowered.reserve(statements.size());
+    for (auto* statement : statements) {
+        lowered.push_back(lower(statement));
+    }
+    return lowered;
+}
+
+LoweredBody* ClosureEngine::lowerBody(Function* function) {
+    auto* body = _arena->make<LoweredBody>();
+    body->statements = lower(function->body);
+    return body;
+}
+
+//==============================================================================
+// Expressions
+//==============================================================================
+void ClosureEngine::visitBinaryExpr(Binary* b) {
+    auto left = lower(b->left);
+    auto right = lower(b->right);
+    int line = b->line;
+
+    switch (b->op) {
+    case TokenType::MINUS:
+        _expr = arithmetic(std::move(left), std::move(right), line, "Operands must be double.",
+            [](const Value& a, const Value& b) {return a - b;});
+        return;
+    case TokenType::SLASH:
+        _expr = arithmetic(std::move(left), std::move(right), line, "Operands must be double.",
+            [](const Value& a, const Value& b) {return a / b;});
+        return;
+    case TokenType::STAR:
+        _expr = arithmetic(std::move(left), std::move(right), line, "Operands must be double.",
+            [](const Value& a, const Value& b) {return a * b;});
+        return;
+    case TokenType::PLUS:
+        _expr = arithmetic(std::move(left), std::move(right), line, "Operands must be double or string.",
+            [](const Value& a, const Value& b) {return a + b;});
+        return;
+    case TokenType::GREATER:
+        _expr = comparison(std::move(left), std::move(right), line, [](const Value& a, const Value& b) {return a > b;});
+        return;
+    case TokenType::GREATER_EQUAL:
+        _expr = comparison(std::move(left), std::move(right), line, [](const Value& a, const Value& b) {return a >= b;});
+        return;
+    case TokenType::LESS:
+        _expr = comparison(std::move(left), std::move(right), line, [](const Value& a, const Value& b) {return a < b;});
+        return;
+    case TokenType::LESS_EQUAL:
+        _expr = comparison(std::move(left), std::move(right), line, [](const Value& a, const Value& b) {return a <= b;});
+        return;
+    case TokenType::EQUAL_EQUAL:
+        _expr = [left = std::move(left), right = std::move(right)](ClosureEngine& engine) {
+            const Value a = left(engine);
+            const Value b = right(engine);
+            return Value{a == b};
+        };
+        return;
+    case TokenType::BANG_EQUAL:
+        _expr = [left = std::move(left), right = std::move(right)](ClosureEngine& engine) {
+            const Value a = left(engine);
+            const Value b = right(engine);
+            return Value{a != b};
+        };
+        return;
+    default:
+        break;
+    }
+
+    _expr = [left = std::move(left), right = std::move(right)](ClosureEngine& engine) {
+        left(engine);
+        right(engine);
+        return Value{};
+    };
+}
+
+void ClosureEngine::visitGroupingExpr(Grouping* g) {
+    _expr = lower(g->expression);
+}
+
+void ClosureEngine::visitUnaryExpr(Unary* u) {
+    auto right = lower(u->expression);
+    int line = u->line;
+
+    switch (u->op) {
+    case TokenType::BANG:
+        _expr = [right = std::move(right)](ClosureEngine& engine) {
+            return Value{!isTruthy(right(engine))};
+        };
+        return;
+    case TokenType::MINUS:
+        _expr = [right = std::move(right), line](ClosureEngine& engine) {
+            Value value = right(engine);
+            if (!value.isNumber()) throw RuntimeError{line, "Operand must be a number."};
+            return -value;
+        };
+        return;
+    default:
+        break;
+    }
+
+    _expr = [right = std::move(right)](ClosureEngine& engine) {
+        right(engine);
+        return Value{};
+    };
+}
+
+void ClosureEngine::visitLiteralExpr(Literal* l) {
+    _expr = [value = l->value](ClosureEngine&) {
+        return value;
+    };
+}
+
+void ClosureEngine::visitVariableExpr(Variable* v) {
+    int slot = v->slot;
+    switch (v->storage) {
+    case Storage::STACK:
+        _expr = [slot](ClosureEngine& engine) {
+            return engine._stack[engine._frame + slot];
+        };
+        return;
+    case Storage::CELL:
+        _expr = [slot](ClosureEngine& engine) {
+            return engine._cells[engine._cellFrame + slot]->value;
+        };
+        return;
+    case Storage::UPVALUE:
+        _expr = [slot](ClosureEngine& engine) {
+            return (*engine._upvalues)[slot]->value;
+        };
+        return;
+    case Storage::GLOBAL:
+        break;
+    }
+
+    _expr = [global = v->global, name = v->name](ClosureEngine&) {
+        if (!global->defined) {
+            throw RuntimeError{name,"Undefined variable '" + std::string{name.text()} + "'."};
+        }
+        return global->value;
+    };
+}
+
+void ClosureEngine::visitAssignExpr(Assign* a) {
+    auto value = lower(a->value);
+    int slot = a->slot;
+
+    switch (a->storage) {
+    case Storage::STACK:
+        _expr = [value = std::move(value), slot](ClosureEngine& engine) {
+            Value result = value(engine);
+            engine._stack[engine._frame + slot] = result;
+            return result;
+        };
+        return;
+    case Storage::CELL:
+        _expr = [value = std::move(value), slot](ClosureEngine& engine) {
+            Value result = value(engine);
+            engine._cells[engine._cellFrame + slot]->value = result;
+            return result;
+        };
+        return;
+    case Storage::UPVALUE:
+        _expr = [value = std::move(value), slot](ClosureEngine& engine) {
+            Value result = value(engine);
+            (*engine._upvalues)[slot]->value = result;
+            return result;
+        };
+        return;
+    case Storage::GLOBAL:
+        break;
+    }
+
+    _expr = [value = std::move(value), global = a->global, name = a->name](ClosureEngine& engine) {
+        Value result = value(engine);
+        if (!global->defined) {
+            throw RuntimeError{name, "Undefined variable " + std::string{name.text()} + "."};
+        }
+        global->value = result;
+        return result;
+    };
+}
+
+void ClosureEngine::visitLogicalExpr(Logical* l) {
+    auto left = lower(l->left);
+    auto right = lower(l->right);
+
+    // OR short-circuit
+    if (l->op == TokenType::OR) {
+        _expr = [left = std::move(left), right = std::move(right)](ClosureEngine& engine) {
+            Value value = left(engine);
+            if (isTruthy(value)) return value;
+            return right(engine);
+        };
+    } else {
+        _expr = [left = std::move(left), right = std::move(right)](ClosureEngine& engine) {
+            Value value = left(engine);
+            if (!isTruthy(value)) return value;
+            return right(engine);
+        };
+    }
+}
+
+void ClosureEngine::visitCallExpr(Call* c) {
+    auto callee = lower(c->callee);
+    std::vector<ExprFn> arguments{};
+    arguments.reserve(c->arguments.size());
+    for (auto* argument : c->arguments) {
+        arguments.push_back(lower(argument));
+    }
+
+    _expr = [callee = std::move(callee), arguments = std::move(arguments), line = c->line](ClosureEngine& engine) {
+        Value function = callee(engine);
+
+        // Arguments go straight onto the stack, where the callee's frame starts
+        size_t base = engine._stack.size();
+        for (auto& argument : arguments) {
+            Value value = argument(engine);
+            engine._stack.push_back(std::move(value));
+        }
+
+        if (!function.isCallable()) {
+            throw RuntimeError{line, "Can only call functions and classes."};
+        }
+
+        Value result = engine.call(function.asCallable(), arguments.size());
+        engine._stack.resize(base);
+        return result;
+    };
+}
+
+//==============================================================================
+// Statements
+//==============================================================================
+void ClosureEngine::visitExpressionStmt(Expression* stmt) {
+    _stmt = [expr = lower(stmt->expr)](ClosureEngine& engine) {
+        expr(engine);
+        return Completion::NORMAL;
+    };
+}
+
+void ClosureEngine::visitIfStmt(If* stmt) {
+    auto condition = lower(stmt->condition);
+    auto thenBranch = lower(stmt->thenBranch);
+    if (stmt->elseBranch == nullptr) {
+        _stmt = [condition = std::move(condition), thenBranch = std::move(thenBranch)](ClosureEngine& engine) {
+            if (isTruthy(condition(engine))) return thenBranch(engine);
+            return Completion::NORMAL;
+        };
+        return;
+    }
+
+    _stmt = [condition = std::move(condition), thenBranch = std::move(thenBranch),
+             elseBranch = lower(stmt->elseBranch)](ClosureEngine& engine) {
+        if (isTruthy(condition(engine))) return thenBranch(engine);
+        return elseBranch(engine);
+    };
+}
+
+void ClosureEngine::visitPrintStmt(Print* stmt) {
+    _stmt = [value = lower(stmt->value)](ClosureEngine& engine) {
+        auto val = value(engine);
+        if (val.isString()) {
+            // Straight from the shared characters, without a copy
+            auto text = val.asString();
+            std::cout.write(text.data(),text.size())<<std::endl;
+        } else {
+            std::cout<<Interpreter::stringify(val)<<std::endl;
+        }
+        return Completion::NORMAL;
+    };
+}
+
+void ClosureEngine::visitFunctionStmt(Function* stmt) {
+    // A deferred body is lowered once it has been parsed, on the first call
+    if (stmt->deferred == nullptr) stmt->lowered = lowerBody(stmt);
+
+    auto closure = [stmt](ClosureEngine& engine) {
+        return Value{new LoxFunction{stmt, engine.capture(stmt)}};
+    };
+
+    // A local function can call itself, so its own cell has to exist before
+    // the closure captures it
+    if (stmt->storage == Storage::CELL) {
+        _stmt = [closure, slot = stmt->slot](ClosureEngine& engine) {
+            auto& cell = engine._cells[engine._cellFrame + slot];
+            cell = std::make_shared<Cell>();
+            cell->value = closure(engine);
+            return Completion::NORMAL;
+        };
+        return;
+    }
+    _stmt = define(stmt->storage, stmt->slot, stmt->global, closure);
+}
+
+// The value waits in _returnValue while every statement up to the function
+// body passes the completion on
+void ClosureEngine::visitReturnStmt(Return* stmt) {
+    if (stmt->value == nullptr) {
+        _stmt = [](ClosureEngine& engine) {
+            engine._returnValue = Value{};
+            return Completion::RETURN;
+        };
+        return;
+    }
+
+    _stmt = [value = lower(stmt->value)](ClosureEngine& engine) {
+        engine._returnValue = value(engine);
+        return Completion::RETURN;
+    };
+}
+
+void ClosureEngine::visitVarStmt(Var* stmt) {
+    ExprFn value{};
+    if (stmt->initializer != nullptr) {
+        value = lower(stmt->initializer);
+    } else {
+        value = [](ClosureEngine&) {return Value{};};
+    }
+    _stmt = define(stmt->storage, stmt->slot, stmt->global, std::move(value));
+}
+
+void ClosureEngine::visitBlockStmt(Block* stmt) {
+    _stmt = [statements = lower(stmt->statements)](ClosureEngine& engine) {
+        for (auto& statement : statements) {
+            auto completion = statement(engine);
+            if (completion != Completion::NORMAL) return completion;
+        }
+        return Completion::NORMAL;
+    };
+}
+
+void ClosureEngine::visitWhileStmt(While* w) {
+    _stmt = [condition = lower(w->expr), body = lower(w->body)](ClosureEngine& engine) {
+        while (isTruthy(condition(engine))) {
+            auto completion = body(engine);
+            if (completion != Completion::NORMAL) return completion;
+        }
+        return Completion::NORMAL;
+    };
+}
+
+// A declaration's first value
+StmtFn ClosureEngine::define(Storage storage, int slot, Global* global, ExprFn value) {
+    switch (storage) {
+    case Storage::STACK:
+        return [value = std::move(value), slot](ClosureEngine& engine) {
+            engine._stack[engine._frame + slot] = value(engine);
+            return Completion::NORMAL;
+        };
+    case Storage::CELL:
+        return [value = std::move(value), slot](ClosureEngine& engine) {
+            engine._cells[engine._cellFrame + slot] = std::make_shared<Cell>(Cell{value(engine)});
+            return Completion::NORMAL;
+        };
+    case Storage::UPVALUE:
+        break;
+    case Storage::GLOBAL:
+        return [value = std::move(value), global](ClosureEngine& engine) {
+            global->value = value(engine);
+            global->defined = true;
+            return Completion::NORMAL;
+        };
+    }
+    return [value = std::move(value)](ClosureEngine& engine) {
+        value(engine);
+        return Completion::NORMAL;
+    };
+}
+
+//==============================================================================
+// Calls
+//==============================================================================
+// Lox functions run their lowered bodies here; anything else is a native
+Value ClosureEngine::call(LoxCallable* callable, size_t argc) {
+    auto* function = callable->asFunction();
+    if (function == nullptr) {
+        // Natives read their arguments off the interpreter's stack
+        return _interpreter->call(callable, _stack.data() + _stack.size() - argc, argc);
+    }
+
+    auto* declaration = function->function();
+    if (declaration->lowered == nullptr) {
+        // compileDeferred forgets which program the body came from
+        _arena = &declaration->deferred->program->arena;
+        Lox::compileDeferred(declaration);
+        declaration->lowered = lowerBody(declaration);
+    }
+    return executeCall(declaration, function->captures(), argc);
+}
+
+Value ClosureEngine::executeCall(Function* function, const Upvalues& upvalues, size_t argc) {
+    return executeFrame(function, upvalues, argc, function->lowered->statements, [this](const StmtFn& statement) {
+        return statement(*this);
+    });
+}
+
+} // Lox namespace
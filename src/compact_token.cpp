@@ -0,0 +1,35 @@
+#include "../include/compact_token.hpp"
+#include "../include/string_table.hpp"
+
+#include <charconv>
+#include <string>
+
+namespace Lox {
+
+Value CompactToken::decodeLiteral(TokenType type, std::string_view text) {
+    switch (type)
+    {
+    case TokenType::NUMBER: {
+        double value = 0;
+        std::from_chars(text.data(), text.data() + text.length(), value);
+        // Integral literals become integers
+        return Value::number(value);
+    }
+    case TokenType::STRING:
+        // Strip the surrounding quote symbols
+        return Value{StringTable::intern(text.substr(1, text.length() - 2))};
+    case TokenType::IDENTIFIER:
+        // The name, for resolving by pointer
+        return Value{StringTable::intern(text)};
+    default:
+        return Value{};
+    }
+}
+
+Token CompactToken::withLexeme(std::string_view lexeme) const {
+    // The interned name already holds an identifier's text
+    if (type == TokenType::IDENTIFIER) return Token{type, std::string{}, decodeLiteral(type, lexeme), line};
+    return Token{type, std::string{lexeme}, decodeLiteral(type, lexeme), line};
+}
+
+} // Lox namespace
@@ -0,0 +1,327 @@
+#include "../include/compiler.hpp"
+#include "../include/lox.hpp"
+
+namespace Lox {
+
+// The top level runs in a frame of its own, like a call without arguments
+Chunk* Compiler::compile(Program& program) {
+    _arena = &program.arena;
+    _chunk = _arena->make<Chunk>();
+    _chunk->frameSize = program.frameSize;
+    _chunk->cells = program.cells;
+    _depth = 0;
+
+    for (auto* statement : program.statements) {
+        compile(statement);
+    }
+    emit(OpCode::NIL, 1);
+    emit(OpCode::RETURN, -1);
+    return _chunk;
+}
+
+void Compiler::compile(Function* function, Arena& arena) {
+    _arena = &arena;
+    function->code = compileFunction(function);
+}
+
+Chunk* Compiler::compileFunction(Function* function) {
+    auto* enclosing = _chunk;
+    int enclosingDepth = _depth;
+    int enclosingLine = _line;
+
+    _chunk = _arena->make<Chunk>();
+    _chunk->frameSize = function->frameSize;
+    _chunk->cells = function->cells;
+    _depth = 0;
+    for (size_t i = 0; i < function->params.size(); i++) {
+        if (function->params[i].storage == Storage::CELL) _chunk->cellParams.push_back(static_cast<uint16_t>(i));
+    }
+
+    for (auto* statement : function->body) {
+        compile(statement);
+    }
+    // Falling off the end returns nil
+    emit(OpCode::NIL, 1);
+    emit(OpCode::RETURN, -1);
+
+    auto* chunk = _chunk;
+    _chunk = enclosing;
+    _depth = enclosingDepth;
+    _line = enclosingLine;
+    return chunk;
+}
+
+void Compiler::compile(Expr* expr) {
+    expr->accept(this);
+}
+
+void Compiler::compile(Stmt* stmt) {
+    stmt->accept(this);
+}
+
+//==============================================================================
+// Expr visitor
+//==============================================================================
+void Compiler::visitBinaryExpr(Binary* expr) {
+    compile(expr->left);
+    compile(expr->right);
+
+    _line = expr->line;
+    switch (expr->op) {
+    case TokenType::MINUS: emit(OpCode::SUBTRACT, -1); break;
+    case TokenType::SLASH: emit(OpCode::DIVIDE, -1); break;
+    case TokenType::STAR: emit(OpCode::MULTIPLY, -1); break;
+    case TokenType::PLUS: emit(OpCode::ADD, -1); break;
+    case TokenType::GREATER: emit(OpCode::GREATER, -1); break;
+    case TokenType::GREATER_EQUAL: emit(OpCode::GREATER_EQUAL, -1); break;
+    case TokenType::LESS: emit(OpCode::LESS, -1); break;
+    case TokenType::LESS_EQUAL: emit(OpCode::LESS_EQUAL, -1); break;
+    case TokenType::EQUAL_EQUAL: emit(OpCode::EQUAL, -1); break;
+    case TokenType::BANG_EQUAL: emit(OpCode::NOT_EQUAL, -1); break;
+    default:
+        // The tree-walker makes nil of anything else
+        emit(OpCode::POP, -1);
+        emit(OpCode::POP, -1);
+        emit(OpCode::NIL, 1);
+        break;
+    }
+}
+
+void Compiler::visitGroupingExpr(Grouping* expr) {
+    compile(expr->expression);
+}
+
+void Compiler::visitUnaryExpr(Unary* expr) {
+    compile(expr->expression);
+
+    _line = expr->line;
+    switch (expr->op) {
+    case TokenType::BANG: emit(OpCode::NOT, 0); break;
+    case TokenType::MINUS: emit(OpCode::NEGATE, 0); break;
+    default:
+        emit(OpCode::POP, -1);
+        emit(OpCode::NIL, 1);
+        break;
+    }
+}
+
+void Compiler::visitLiteralExpr(Literal* expr) {
+    const auto& value = expr->value;
+    if (value.isNil()) emit(OpCode::NIL, 1);
+    else if (value.isBool()) emit(value.asBool() ? OpCode::TRUE : OpCode::FALSE, 1);
+    else emitConstant(value);
+}
+
+void Compiler::visitVariableExpr(Variable* expr) {
+    _line = expr->name.line;
+    switch (expr->storage) {
+    case Storage::STACK: emitSlot(OpCode::GET_LOCAL, 1, expr->slot); break;
+    case Storage::CELL: emitSlot(OpCode::GET_CELL, 1, expr->slot); break;
+    case Storage::UPVALUE: emitSlot(OpCode::GET_UPVALUE, 1, expr->slot); break;
+    case Storage::GLOBAL: emitGlobal(OpCode::GET_GLOBAL, 1, expr->global); break;
+    }
+}
+
+void Compiler::visitAssignExpr(Assign* expr) {
+    compile(expr->value);
+
+    _line = expr->name.line;
+    store(expr->storage, expr->slot, expr->global, false);
+}
+
+// The left operand is the result when it decides, otherwise it is dropped
+// for the right one
+void Compiler::visitLogicalExpr(Logical* expr) {
+    compile(expr->left);
+    size_t end = emitJump(expr->op == TokenType::OR ? OpCode::JUMP_IF_TRUE : OpCode::JUMP_IF_FALSE, 0);
+    emit(OpCode::POP, -1);
+    compile(expr->right);
+    patchJump(end);
+}
+
+void Compiler::visitCallExpr(Call* expr) {
+    compile(expr->callee);
+    for (auto* argument : expr->arguments) {
+        compile(argument);
+    }
+
+    _line = expr->line;
+    int argc = static_cast<int>(expr->arguments.size());
+    emit(OpCode::CALL, -argc);
+    write16(static_cast<uint16_t>(argc));
+}
+
+//==============================================================================
+// Stmt visitor
+//==============================================================================
+// An assignment to a stack slot whose value nobody uses stores and pops in
+// one go
+void Compiler::visitExpressionStmt(Expression* stmt) {
+    if (stmt->expr->kind == ExprKind::ASSIGN) {
+        auto* assign = static_cast<Assign*>(stmt->expr);
+        if (assign->storage == Storage::STACK) {
+            compile(assign->value);
+            emitSlot(OpCode::STORE_LOCAL, -1, assign->slot);
+            return;
+        }
+    }
+    compile(stmt->expr);
+    emit(OpCode::POP, -1);
+}
+
+void Compiler::visitFunctionStmt(Function* stmt) {
+    // A deferred body is compiled once it has been parsed, on the first call
+    if (stmt->deferred == nullptr) stmt->code = compileFunction(stmt);
+
+    size_t index = _chunk->functions.size();
+    _chunk->functions.push_back(stmt);
+
+    // A local function can call itself, so its own cell has to exist before
+    // the closure captures it
+    if (stmt->storage == Storage::CELL) {
+        emitSlot(OpCode::NEW_CELL, 0, stmt->slot);
+        emitIndex(OpCode::CLOSURE, 1, index);
+        emitSlot(OpCode::SET_CELL, 0, stmt->slot);
+        emit(OpCode::POP, -1);
+        return;
+    }
+    emitIndex(OpCode::CLOSURE, 1, index);
+    store(stmt->storage, stmt->slot, stmt->global, true);
+}
+
+void Compiler::visitReturnStmt(Return* stmt) {
+    if (stmt->value != nullptr) compile(stmt->value);
+    else emit(OpCode::NIL, 1);
+    emit(OpCode::RETURN, -1);
+}
+
+void Compiler::visitVarStmt(Var* stmt) {
+    if (stmt->initializer != nullptr) compile(stmt->initializer);
+    else emit(OpCode::NIL, 1);
+
+    _line = stmt->name.line;
+    store(stmt->storage, stmt->slot, stmt->global, true);
+}
+
+void Compiler::visitPrintStmt(Print* stmt) {
+    compile(stmt->value);
+    emit(OpCode::PRINT, -1);
+}
+
+// A block's locals have their slots in the enclosing frame already
+void Compiler::visitBlockStmt(Block* stmt) {
+    for (auto* statement : stmt->statements) {
+        compile(statement);
+    }
+}
+
+void Compiler::visitIfStmt(If* stmt) {
+    compile(stmt->condition);
+    size_t elseBranch = emitJump(OpCode::POP_JUMP_IF_FALSE, -1);
+    compile(stmt->thenBranch);
+    if (stmt->elseBranch == nullptr) {
+        patchJump(elseBranch);
+        return;
+    }
+    size_t end = emitJump(OpCode::JUMP, 0);
+    patchJump(elseBranch);
+    compile(stmt->elseBranch);
+    patchJump(end);
+}
+
+void Compiler::visitWhileStmt(While* stmt) {
+    size_t start = _chunk->code.size();
+    compile(stmt->expr);
+    size_t exit = emitJump(OpCode::POP_JUMP_IF_FALSE, -1);
+    compile(stmt->body);
+    emitLoop(start);
+    patchJump(exit);
+}
+
+//==============================================================================
+// Emitting
+//==============================================================================
+// Assignments leave the value on the stack as the expression's result, a
+// declaration consumes it
+void Compiler::store(Storage storage, int slot, Global* global, bool define) {
+    switch (storage) {
+    case Storage::STACK:
+        if (define) emitSlot(OpCode::STORE_LOCAL, -1, slot);
+        else emitSlot(OpCode::SET_LOCAL, 0, slot);
+        break;
+    case Storage::CELL:
+        if (define) emitSlot(OpCode::DEFINE_CELL, -1, slot);
+        else emitSlot(OpCode::SET_CELL, 0, slot);
+        break;
+    case Storage::UPVALUE:
+        emitSlot(OpCode::SET_UPVALUE, 0, slot);
+        if (define) emit(OpCode::POP, -1);
+        break;
+    case Storage::GLOBAL:
+        if (define) emitGlobal(OpCode::DEFINE_GLOBAL, -1, global);
+        else emitGlobal(OpCode::SET_GLOBAL, 0, global);
+        break;
+    }
+}
+
+void Compiler::emit(OpCode op, int stackEffect) {
+    auto& lines = _chunk->lines;
+    if (lines.empty() || lines.back().line != _line) {
+        lines.push_back(LineStart{static_cast<uint32_t>(_chunk->code.size()), _line});
+    }
+    _chunk->code.push_back(static_cast<uint8_t>(op));
+
+    _depth += stackEffect;
+    _chunk->maxStack = std::max(_chunk->maxStack, _depth);
+}
+
+void Compiler::emitSlot(OpCode op, int stackEffect, int slot) {
+    if (slot > UINT16_MAX) Lox::error(_line, "Too many local variables in function.");
+    emit(op, stackEffect);
+    write16(static_cast<uint16_t>(slot));
+}
+
+void Compiler::emitIndex(OpCode op, int stackEffect, size_t index) {
+    emit(op, stackEffect);
+    write32(static_cast<uint32_t>(index));
+}
+
+size_t Compiler::emitJump(OpCode op, int stackEffect) {
+    emit(op, stackEffect);
+    write32(0);
+    return _chunk->code.size() - 4;
+}
+
+void Compiler::patchJump(size_t operand) {
+    uint32_t distance = static_cast<uint32_t>(_chunk->code.size() - operand - 4);
+    std::memcpy(&_chunk->code[operand], &distance, sizeof distance);
+}
+
+void Compiler::emitLoop(size_t start) {
+    emit(OpCode::LOOP, 0);
+    write32(static_cast<uint32_t>(_chunk->code.size() + 4 - start));
+}
+
+void Compiler::emitConstant(const Value& value) {
+    emitIndex(OpCode::CONSTANT, 1, _chunk->constants.size());
+    _chunk->constants.push_back(value);
+}
+
+void Compiler::emitGlobal(OpCode op, int stackEffect, Global* global) {
+    emitIndex(op, stackEffect, _chunk->globals.size());
+    _chunk->globals.push_back(global);
+}
+
+void Compiler::write16(uint16_t operand) {
+    uint8_t bytes[sizeof operand];
+    std::memcpy(bytes, &operand, sizeof operand);
+    _chunk->code.insert(_chunk->code.end(), bytes, bytes + sizeof operand);
+}
+
+void Compiler::write32(uint32_t operand) {
+    uint8_t bytes[sizeof operand];
+    std::memcpy(bytes, &operand, sizeof operand);
+    _chunk->code.insert(_chunk->code.end(), bytes, bytes + sizeof operand);
+}
+
+} // Lox namespace
@@ -0,0 +1,16 @@
+#include "../include/frame_stack.hpp"
+
+namespace Lox {
+
+// The cells a new closure of `function` keeps: only the ones it uses, taken
+// from the running frame or passed down from the running closure
+Upvalues FrameStack::capture(Function* function) {
+    Upvalues upvalues{};
+    upvalues.reserve(function->upvalues.size());
+    for (auto& capture : function->upvalues) {
+        upvalues.push_back(capture.local ? _cells[_cellFrame + capture.index] : (*_upvalues)[capture.index]);
+    }
+    return upvalues;
+}
+
+} // Lox namespace
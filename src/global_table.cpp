@@ -0,0 +1,25 @@
+#include "../include/global_table.hpp"
+#include "../include/string_table.hpp"
+
+namespace Lox {
+
+Global* GlobalTable::intern(const Value& name) {
+    auto id = _ids.find(name.asLoxString());
+    if (id != _ids.end()) return &_globals[id->second];
+
+    _ids.emplace(name.asLoxString(), _globals.size());
+    _globals.push_back(Global{name, Value{}, false});
+    return &_globals.back();
+}
+
+Global* GlobalTable::intern(std::string_view name) {
+    return intern(Value{StringTable::intern(name)});
+}
+
+void GlobalTable::define(std::string_view name, Value value) {
+    auto* global = intern(name);
+    global->value = std::move(value);
+    global->defined = true;
+}
+
+} // Lox namespace
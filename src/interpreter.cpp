@@ -2,11 +2,13 @@
 
 namespace Lox {
 
-Interpreter::Interpreter() : globals{std::make_shared<Environment>()}, _environment{globals} {
-    globals->define("clock",Value{std::make_shared<ClockCallable>()});
+// Top-level code has globals, and a frame for the locals of its blocks
+Interpreter::Interpreter()
+: globals{} {
+    globals.define("clock",Value{new ClockCallable{}});
 }
 
-void Interpreter::interpret(std::unique_ptr<Expr>& expression) {
+void Interpreter::interpret(Expr* expression) {
     try {
         Value value = evaluate(expression);
         std::cout<<stringify(value) << std::endl;
@@ -15,56 +17,69 @@ void Interpreter::interpret(std::unique_ptr<Expr>& expression) {
     }
 }
 
-void Interpreter::interpret(std::vector<std::unique_ptr<Stmt>>& statments) {
+void Interpreter::interpret(Program& program) {
+    _frame = 0;
+    _cellFrame = 0;
+    _upvalues = nullptr;
+    _stack.resize(program.frameSize);
+    _cells.resize(program.cells);
     try {
-        for (auto& statement : statments) {
+        for (auto* statement : program.statements) {
             execute(statement);
         }
     } catch(RuntimeError& error) {
         Lox::runtimeError(error);
     }
-    
+    // An error can leave any number of calls' frames behind
+    _stack.clear();
+    _cells.clear();
 }
 
 //==============================================================================
-// ExprVisitor<Value> implementation
+// Expr visitor implementation
 //==============================================================================
 Value Interpreter::visitBinaryExpr(Binary* b) {
     const Value left = evaluate(b->left);
     const Value right = evaluate(b->right);
 
-    switch (b->op.type)
+    // Arithmetic only makes nil out of operands of the wrong type, so it is
+    // checked after the fact; two integers compare without a check
+    switch (b->op)
     {
     case TokenType::MINUS: {
-        checkNumberOperands(b->op,left,right);
-        return left - right;
+        Value result = left - right;
+        if (result.isNil()) checkNumberOperands(b->line,left,right);
+        return result;
     }
     case TokenType::SLASH: {
-        checkNumberOperands(b->op,left,right);   
-        return left / right;
+        Value result = left / right;
+        if (result.isNil()) checkNumberOperands(b->line,left,right);
+        return result;
     }
     case TokenType::STAR: {
-        checkNumberOperands(b->op,left,right);
-        return left * right;
+        Value result = left * right;
+        if (result.isNil()) checkNumberOperands(b->line,left,right);
+        return result;
     }
     case TokenType::PLUS: {
-        checkAdditionOperation(b->op,left,right);
-        return left + right;
+        Value result = left + right;
+        if (result.isNil()) checkAdditionOperation(b->line,left,right);
+        return result;
     }
     case TokenType::GREATER: {
-        checkNumberOperands(b->op,left,right);
+        if (!left.isInt() || !right.isInt()) checkNumberOperands(b->line,left,right);
         return Value{left > right};
     }
     case TokenType::GREATER_EQUAL: {
-        checkNumberOperands(b->op,left,right);
+        if (!left.isInt() || !right.isInt()) checkNumberOperands(b->line,left,right);
         return Value{left >= right};
     }
     case TokenType::LESS: {
-        checkNumberOperands(b->op,left,right);
+        if (!left.isInt() || !right.isInt()) checkNumberOperands(b->line,left,right);
         return Value{left < right};
     }
     case TokenType::LESS_EQUAL: {
-        checkNumberOperands(b->op,left,right);
+        if (!left.isInt() || !right.isInt()) checkNumberOperands(b->line,left,right);
         return Value{left <= right};
     }
     case TokenType::EQUAL_EQUAL: {
@@ -77,7 +92,7 @@ Value Interpreter::visitBinaryExpr(Binary* b) {
         break;
     }
 
-    return Value{std::monostate{}};
+    return Value{};
 }
 
 Value Interpreter::visitGroupingExpr(Grouping* g) {
@@ -87,24 +102,20 @@ Value Interpreter::visitGroupingExpr(Grouping* g) {
 Value Interpreter::visitUnaryExpr(Unary* u) {
     Value right = evaluate(u->expression);
 
-    switch (u->op.type)
+    switch (u->op)
     {
     case TokenType::BANG: {
         return Value{!isTruthy(right)};
     }
     case TokenType::MINUS: {
-        checkNumberOperand(u->op,right);
-        if (std::holds_alternative<double>(right.item)) {
-            double v = -std::get<double>(right.item);
-            right = Value{v};
-            return right;
-        }
+        checkNumberOperand(u->line,right);
+        return -right;
     }
     default:
         break;
     }
 
-    return Value{std::monostate{}};
+    return Value{};
 }
 
 Value Interpreter::visitLiteralExpr(Literal* l) {
@@ -112,28 +123,41 @@ Value Interpreter::visitLiteralExpr(Literal* l) {
 }
 
 Value Interpreter::visitVariableExpr(Variable* v) {
-    return lookUpVariable(v->name,v);
-}
-
-Value Interpreter::lookUpVariable(const Token& name, Expr* expr) {
-    if (_locals.find(expr) != _locals.end()) {
-        int distance = _locals[expr];
-        return _environment->getAt(distance,name.lexeme);
-    } else {
-        return globals->get(name);
+    switch (v->storage) {
+    case Storage::STACK:
+        return _stack[_frame + v->slot];
+    case Storage::CELL:
+        return _cells[_cellFrame + v->slot]->value;
+    case Storage::UPVALUE:
+        return (*_upvalues)[v->slot]->value;
+    case Storage::GLOBAL:
+        break;
     }
-
+    if (!v->global->defined) {
+        throw RuntimeError{v->name,"Undefined variable '" + std::string{v->name.text()} + "'."};
+    }
+    return v->global->value;
 }
 
 Value Interpreter::visitAssignExpr(Assign* a) {
     Value value = evaluate(a->value);
 
-    if (_locals.find(a) != _locals.end()) {
-        int distance = _locals.at(a);
-        _environment->assignAt(distance,a->name,value);
-
-    } else {
-        globals->assign(a->name,value);
+    switch (a->storage) {
+    case Storage::STACK:
+        _stack[_frame + a->slot] = value;
+        break;
+    case Storage::CELL:
+        _cells[_cellFrame + a->slot]->value = value;
+        break;
+    case Storage::UPVALUE:
+        (*_upvalues)[a->slot]->value = value;
+        break;
+    case Storage::GLOBAL:
+        if (!a->global->defined) {
+            throw RuntimeError{a->name, "Undefined variable " + std::string{a->name.text()} + "."};
+        }
+        a->global->value = value;
+        break;
     }
 
     return value;
@@ -143,7 +167,7 @@ Value Interpreter::visitLogicalExpr(Logical* l) {
     Value left = evaluate(l->left);
 
     // OR short-circuit
-    if (l->op.type == TokenType::OR) { 
+    if (l->op == TokenType::OR) { 
         if (isTruthy(left)) return left;
     } else {
         if (!isTruthy(left)) return left; 
@@ -155,70 +179,101 @@ Value Interpreter::visitLogicalExpr(Logical* l) {
 Value Interpreter::visitCallExpr(Call* c) {
     Value callee = evaluate(c->callee);
 
-    std::list<Value> args{};
-    for (auto& argument : c->arguments) {
-        args.push_back(evaluate(argument));
+    // Arguments go straight onto the stack, where the callee's frame starts
+    size_t base = _stack.size();
+    for (auto* argument : c->arguments) {
+        Value value = evaluate(argument);
+        _stack.push_back(std::move(value));
     }
 
-    if (!std::holds_alternative<std::shared_ptr<LoxCallable>>(callee.item)) {
-        throw RuntimeError{c->paren, "Can only call functions and classes."};
+    if (!callee.isCallable()) {
+        throw RuntimeError{c->line, "Can only call functions and classes."};
     }
-    auto function = std::get<std::shared_ptr<LoxCallable>>(callee.item);
 
-    return function->call(this,args);
+    Value result = callee.asCallable()->call(this,c->arguments.size());
+    _stack.resize(base);
+    return result;
 }
 
 //==============================================================================
-// StmtVisitor<void> implementation
+// Stmt visitor implementation
 //==============================================================================
-void Interpreter::visitExpressionStmt(Expression* stmt) {
+Completion Interpreter::visitExpressionStmt(Expression* stmt) {
     evaluate(stmt->expr);
+    return Completion::NORMAL;
 }
 
-void Interpreter::visitIfStmt(If* stmt) {
+Completion Interpreter::visitIfStmt(If* stmt) {
     if(isTruthy(evaluate(stmt->condition))) {
-        execute(stmt->thenBranch);
-    } else if (stmt->elseBranch.get() != nullptr) {
-        execute(stmt->elseBranch);
+        return execute(stmt->thenBranch);
+    } else if (stmt->elseBranch != nullptr) {
+        return execute(stmt->elseBranch);
     }
+    return Completion::NORMAL;
 }
 
-void Interpreter::visitPrintStmt(Print* stmt) {
+Completion Interpreter::visitPrintStmt(Print* stmt) {
     auto val = evaluate(stmt->value);
-    std::cout<<stringify(val)<<std::endl;
+    if (val.isString()) {
+        // Straight from the shared characters, without a copy
+        auto text = val.asString();
+        std::cout.write(text.data(),text.size())<<std::endl;
+    } else {
+        std::cout<<stringify(val)<<std::endl;
+    }
+    return Completion::NORMAL;
 }
 
-void Interpreter::visitFunctionStmt(Function* stmt) {
-    auto function = std::make_shared<LoxFunction>(stmt,this->_environment);
-    _environment->define(stmt->name.lexeme,Value{function});
+Completion Interpreter::visitFunctionStmt(Function* stmt) {
+    // A local function can call itself, so its own cell has to exist before
+    // the closure captures it
+    if (stmt->storage == Storage::CELL) {
+        auto& cell = _cells[_cellFrame + stmt->slot];
+        cell = std::make_shared<Cell>();
+        cell->value = Value{new LoxFunction{stmt,capture(stmt)}};
+        return Completion::NORMAL;
+    }
+    define(stmt->storage, stmt->slot, stmt->global, Value{new LoxFunction{stmt,capture(stmt)}});
+    return Completion::NORMAL;
 }
 
-void  Interpreter::visitReturnStmt(Return* stmt) {
-    auto value = Value{std::monostate{}};
-    if (stmt->value.get() != nullptr) value = evaluate(stmt->value);
-
-    throw ReturnValue{value};
+// The value waits in _returnValue while every statement up to the function
+// body passes the completion on
+Completion Interpreter::visitReturnStmt(Return* stmt) {
+    if (stmt->value != nullptr) {
+        _returnValue = evaluate(stmt->value);
+    } else {
+        _returnValue = Value{};
+    }
+    return Completion::RETURN;
 }
 
-void Interpreter::visitVarStmt(Var* stmt) {
+Completion Interpreter::visitVarStmt(Var* stmt) {
     Value value{};
 
     if (stmt->initializer != nullptr) {
         value = evaluate(stmt->initializer);
     } 
 
-    _environment->define(stmt->name.lexeme,value);
+    define(stmt->storage, stmt->slot, stmt->global, std::move(value));
+    return Completion::NORMAL;
 }
 
-void Interpreter::visitBlockStmt(Block* stmt) {
-    auto env = std::make_shared<Environment>(this->_environment);
-    executeBlock(stmt->statements,env);
+// A block's locals have their slots in the enclosing call's frame already
+Completion Interpreter::visitBlockStmt(Block* stmt) {
+    for (auto* statement : stmt->statements) {
+        auto completion = execute(statement);
+        if (completion != Completion::NORMAL) return completion;
+    }
+    return Completion::NORMAL;
 }
 
-void Interpreter::visitWhileStmt(While* w) {
+Completion Interpreter::visitWhileStmt(While* w) {
     while (isTruthy(evaluate(w->expr))) {
-        execute(w->body);
+        auto completion = execute(w->body);
+        if (completion != Completion::NORMAL) return completion;
     }
+    return Completion::NORMAL;
 }
 
 
@@ -229,67 +284,78 @@ Value Interpreter::evaluate(Expr* expr) {
     return expr->accept(this);
 }
 
-Value Interpreter::evaluate(std::unique_ptr<Expr>& expr) {
-    return expr->accept(this);
+Completion Interpreter::execute(Stmt* stmt) {
+    return stmt->accept(this);
 }
 
-void Interpreter::execute(std::unique_ptr<Stmt>& stmt) {
-    stmt->accept(this);
+Value Interpreter::executeCall(Function* function, const Upvalues& upvalues, size_t argc) {
+    return executeFrame(function, upvalues, argc, function->body, [this](Stmt* stmt) {
+        return execute(stmt);
+    });
 }
 
-void Interpreter::resolve(Expr* expr,int depth) {
-    _locals[expr] = depth;
+Value Interpreter::call(LoxCallable* callable, const Value* args, size_t argc) {
+    size_t base = _stack.size();
+    _stack.insert(_stack.end(), args, args + argc);
+    Value result = callable->call(this, argc);
+    _stack.resize(base);
+    return result;
 }
 
-void Interpreter::executeBlock(std::list<std::unique_ptr<Stmt>>& statements, std::shared_ptr<Environment> environment) {
-    auto previous = this->_environment;
-    try {
-        this->_environment = environment;
-        for (auto& stmt : statements) {
-            execute(stmt);
-        }
-        this->_environment = previous;
-    } catch(...) {
-        this->_environment = previous;
-        throw;
+// A declaration's first value
+void Interpreter::define(Storage storage, int slot, Global* global, Value value) {
+    switch (storage) {
+    case Storage::STACK:
+        _stack[_frame + slot] = std::move(value);
+        break;
+    case Storage::CELL:
+        _cells[_cellFrame + slot] = std::make_shared<Cell>(Cell{std::move(value)});
+        break;
+    case Storage::UPVALUE:
+        break;
+    case Storage::GLOBAL:
+        global->value = std::move(value);
+        global->defined = true;
+        break;
     }
-
 }
 
 bool Interpreter::isTruthy(const Value& v) {
-    if (std::holds_alternative<std::monostate>(v.item)) return false;
-    if (std::holds_alternative<bool>(v.item)) return std::get<bool>(v.item);
+    if (v.isNil()) return false;
+    if (v.isBool()) return v.asBool();
     return true;
 }
 
 std::string Interpreter::stringify(const Value& v) {
-    if (std::holds_alternative<std::monostate>(v.item)) return "nil";
-    if (std::holds_alternative<double>(v.item)) {
-        std::stringstream text{std::to_string(std::get<double>(v.item))};
+    if (v.isNil()) return "nil";
+    // The digits std::to_string gives the double, without formatting one
+    if (v.isInt()) return std::to_string(v.asInt()) + ".000000";
+    if (v.isNumber()) {
+        std::stringstream text{std::to_string(v.asNumber())};
         return text.str();
     }
-    if (std::holds_alternative<std::string>(v.item)) return std::get<std::string>(v.item);
-    if (std::holds_alternative<bool>(v.item)) return std::get<bool>(v.item) ? "true" : "false";
+    if (v.isString()) return std::string{v.asString()};
+    if (v.isBool()) return v.asBool() ? "true" : "false";
     
 
     return "";
 
 }
 
-void Interpreter::checkNumberOperand(const Token& op, const Value& v) {
-    if (std::holds_alternative<double>(v.item)) return;
-    throw RuntimeError{op, "Operand must be a number."};
+void Interpreter::checkNumberOperand(int line, const Value& v) {
+    if (v.isNumber()) return;
+    throw RuntimeError{line, "Operand must be a number."};
 }
 
-void Interpreter::checkNumberOperands(const Token& op, const Value& l, const Value& r) {
-    if (std::holds_alternative<double>(l.item) && std::holds_alternative<double>(r.item)) return;
-    throw RuntimeError{op,"Operands must be double."};
+void Interpreter::checkNumberOperands(int line, const Value& l, const Value& r) {
+    if (l.isNumber() && r.isNumber()) return;
+    throw RuntimeError{line,"Operands must be double."};
 }
 
-void Interpreter::checkAdditionOperation(const Token& op, const Value& l, const Value& r) {
-    if (std::holds_alternative<double>(l.item) && std::holds_alternative<double>(r.item)) return;
-    if (std::holds_alternative<std::string>(l.item) && std::holds_alternative<std::string>(r.item)) return;
-    throw RuntimeError{op,"Operands must be double or string."};
+void Interpreter::checkAdditionOperation(int line, const Value& l, const Value& r) {
+    if (l.isNumber() && r.isNumber()) return;
+    if (l.isString() && r.isString()) return;
+    throw RuntimeError{line,"Operands must be double or string."};
 }
 
 } // Lox namespace
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include "../include/jit.hpp"
+#include "../include/lox.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define LOX_JIT_X86_64
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Lox {
+
+namespace {
+
+// How deep compiled code may call itself before leaving the recursion to the
+// interpreter, which uses less of the native stack per call
+constexpr int MAX_DEPTH = 4096;
+int depth = 0;
+
+// Called from machine code for a call to a global. Only another compiled
+// function with matching arity is entered; anything else makes the caller
+// bail out.
+int callGlobal(Global* global, const double* args, double* out, uint32_t argc) {
+    if (!global->defined || !global->value.isCallable()) return 1;
+    auto* function = global->value.asCallable()->asFunction();
+    if (function == nullptr) return 1;
+    auto* declaration = function->function();
+    if (declaration->jit == nullptr || declaration->jit->entry == nullptr) return 1;
+    if (declaration->params.size() != argc || depth == MAX_DEPTH) return 1;
+    depth++;
+    int status = declaration->jit->entry(args, out);
+    depth--;
+    return status;
+}
+
+#ifdef LOX_JIT_X86_64
+
+// A jump target. Jumps to it before it is bound are patched when it is.
+class Label {
+public:
+    int64_t offset = -1;
+    std::vector<size_t> uses;
+};
+
+// The few x86-64 instructions the JIT needs. Values live in xmm0 and xmm1,
+// and in 8-byte slots of the frame below rbp; rbx keeps the result pointer.
+class Assembler {
+public:
+    std::vector<uint8_t> code;
+
+    void bytes(std::initializer_list<uint8_t> values) {code.insert(code.end(), values);}
+    void imm32(uint32_t value) {append(&value, sizeof value);}
+    void imm64(uint64_t value) {append(&value, sizeof value);}
+
+    // Slot `slot` of the frame, below the saved rbx
+    static int32_t slotOffset(int slot) {return -16 - 8 * slot;}
+
+    // push rbp; mov rbp, rsp; push rbx; sub rsp, <patched>; mov rbx, rsi
+    size_t prologue() {
+        bytes({0x55, 0x48, 0x89, 0xE5, 0x53, 0x48, 0x81, 0xEC});
+        size_t frameSize = code.size();
+        imm32(0);
+        bytes({0x48, 0x89, 0xF3});
+        return frameSize;
+    }
+    // Room for `slots` slots, leaving rsp 16-byte aligned for calls
+    void patchFrame(size_t at, int slots) {
+        uint32_t size = 8 * slots;
+        if (size % 16 == 0) size += 8;
+        std::memcpy(&code[at], &size, sizeof size);
+    }
+    // mov eax, status; lea rsp, [rbp-8]; pop rbx; pop rbp; ret
+    void epilogue(uint32_t status) {
+        bytes({0xB8});
+        imm32(status);
+        bytes({0x48, 0x8D, 0x65, 0xF8, 0x5B, 0x5D, 0xC3});
+    }
+
+    // movsd xmm0, [rdi+8*index]: the index-th argument
+    void loadArgument(int index) {
+        bytes({0xF2, 0x0F, 0x10, 0x87});
+        imm32(8 * index);
+    }
+    // movsd xmm0/xmm1, [rbp+slot]
+    void load(int xmm, int slot) {
+        bytes({0xF2, 0x0F, 0x10, static_cast<uint8_t>(xmm == 0 ? 0x85 : 0x8D)});
+        imm32(slotOffset(slot));
+    }
+    // movsd [rbp+slot], xmm0
+    void store(int slot) {
+        bytes({0xF2, 0x0F, 0x11, 0x85});
+        imm32(slotOffset(slot));
+    }
+    // movsd [rbx], xmm0
+    void storeResult() {bytes({0xF2, 0x0F, 0x11, 0x03});}
+    // mov rax, bits; movq xmm0, rax
+    void loadConstant(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        bytes({0x48, 0xB8});
+        imm64(bits);
+        bytes({0x66, 0x48, 0x0F, 0x6E, 0xC0});
+    }
+    // movapd xmm1, xmm0
+    void moveToXmm1() {bytes({0x66, 0x0F, 0x28, 0xC8});}
+    // addsd, subsd, mulsd or divsd xmm0, xmm1
+    void arithmetic(uint8_t opcode) {bytes({0xF2, 0x0F, opcode, 0xC1});}
+    // Flip the sign bit: mov rax, 1<<63; movq xmm1, rax; xorpd xmm0, xmm1
+    void negate() {
+        bytes({0x48, 0xB8});
+        imm64(uint64_t{1} << 63);
+        bytes({0x66, 0x48, 0x0F, 0x6E, 0xC8, 0x66, 0x0F, 0x57, 0xC1});
+    }
+    // ucomisd xmm0, xmm1 or, swapped, ucomisd xmm1, xmm0
+    void compare(bool swapped) {bytes({0x66, 0x0F, 0x2E, static_cast<uint8_t>(swapped ? 0xC8 : 0xC1)});}
+
+    // callGlobal(global, args at slot, out at slot, argc), and bail out to
+    // `bail` unless it returned 0
+    void callGlobal(Global* global, int argsSlot, int outSlot, uint32_t argc, Label& bail) {
+        bytes({0x48, 0xBF});
+        imm64(reinterpret_cast<uint64_t>(global));
+        bytes({0x48, 0x8D, 0xB5});
+        imm32(slotOffset(argsSlot));
+        bytes({0x48, 0x8D, 0x95});
+        imm32(slotOffset(outSlot));
+        bytes({0xB9});
+        imm32(argc);
+        bytes({0x48, 0xB8});
+        imm64(reinterpret_cast<uint64_t>(&::Lox::callGlobal));
+        bytes({0xFF, 0xD0, 0x85, 0xC0});
+        jump(JNE, bail);
+    }
+
+    // Condition codes of the jumps, as the second byte of 0F 8x
+    static constexpr uint8_t JB = 0x82;
+    static constexpr uint8_t JAE = 0x83;
+    static constexpr uint8_t JE = 0x84;
+    static constexpr uint8_t JNE = 0x85;
+    static constexpr uint8_t JBE = 0x86;
+    static constexpr uint8_t JA = 0x87;
+    static constexpr uint8_t JP = 0x8A;
+    static constexpr uint8_t JMP = 0;
+
+    void jump(uint8_t condition, Label& target) {
+        if (condition == JMP) bytes({0xE9});
+        else bytes({0x0F, condition});
+        size_t at = code.size();
+        imm32(0);
+        if (target.offset >= 0) patch(at, target.offset);
+        else target.uses.push_back(at);
+    }
+    void bind(Label& label) {
+        label.offset = code.size();
+        for (auto at : label.uses) patch(at, label.offset);
+        label.uses.clear();
+    }
+
+private:
+    void append(const void* data, size_t size) {
+        auto* first = static_cast<const uint8_t*>(data);
+        code.insert(code.end(), first, first + size);
+    }
+    // rel32 counts from the end of the jump
+    void patch(size_t at, int64_t target) {
+        int32_t distance = static_cast<int32_t>(target - static_cast<int64_t>(at + 4));
+        std::memcpy(&code[at], &distance, sizeof distance);
+    }
+};
+
+// Emits a function's machine code straight from its resolved tree. Every
+// expression leaves its value in xmm0; the operands of a binary expression
+// wait in a slot above the locals while the right one is computed. A node
+// outside what can be compiled clears `supported` and the result is thrown
+// away.
+class JitCompiler {
+public:
+    bool supported = true;
+
+    std::vector<uint8_t> compile(Function* function) {
+        if (!function->upvalues.empty() || function->cells > 0) supported = false;
+        _slots = function->frameSize;
+        _next = _slots;
+
+        size_t frame = _as.prologue();
+        for (size_t i = 0; i < function->params.size(); i++) {
+            _as.loadArgument(i);
+            _as.store(function->params[i].slot);
+        }
+        for (auto* stmt : function->body) {
+            if (!supported) break;
+            stmt->accept(this);
+        }
+        // Falling off the end returns nil, which is not a number
+        _as.bind(_bail);
+        _as.epilogue(1);
+        _as.bind(_return);
+        _as.epilogue(0);
+        _as.patchFrame(frame, _slots);
+        return std::move(_as.code);
+    }
+
+    // Expr visitor
+    void visitBinaryExpr(Binary* b) {
+        uint8_t opcode = 0;
+        switch (b->op) {
+        case TokenType::PLUS: opcode = 0x58; break;
+        case TokenType::STAR: opcode = 0x59; break;
+        case TokenType::MINUS: opcode = 0x5C; break;
+        case TokenType::SLASH: opcode = 0x5E; break;
+        default:
+            // Comparisons make booleans, only conditions use them
+            supported = false;
+            return;
+        }
+        operands(b);
+        _as.arithmetic(opcode);
+    }
+    void visitGroupingExpr(Grouping* g) {
+        g->expression->accept(this);
+    }
+    void visitUnaryExpr(Unary* u) {
+        if (u->op != TokenType::MINUS) {
+            supported = false;
+            return;
+        }
+        u->expression->accept(this);
+        _as.negate();
+    }
+    void visitLiteralExpr(Literal* l) {
+        if (!l->value.isNumber()) {
+            supported = false;
+            return;
+        }
+        _as.loadConstant(l->value.asNumber());
+    }
+    void visitVariableExpr(Variable* v) {
+        if (v->storage != Storage::STACK) {
+            supported = false;
+            return;
+        }
+        _as.load(0, v->slot);
+    }
+    void visitAssignExpr(Assign* a) {
+        if (a->storage != Storage::STACK) {
+            supported = false;
+            return;
+        }
+        a->value->accept(this);
+        _as.store(a->slot);
+    }
+    void visitLogicalExpr(Logical*) {
+        supported = false;
+    }
+    // Arguments go to consecutive slots, the first one lowest in memory
+    void visitCallExpr(Call* c) {
+        auto* callee = c->callee->kind == ExprKind::VARIABLE ? static_cast<Variable*>(c->callee) : nullptr;
+        if (callee == nullptr || callee->storage != Storage::GLOBAL) {
+            supported = false;
+            return;
+        }
+        int argc = static_cast<int>(c->arguments.size());
+        int first = reserve(argc + 1);
+        for (int i = 0; i < argc; i++) {
+            c->arguments[i]->accept(this);
+            _as.store(first + argc - 1 - i);
+        }
+        int out = first + argc;
+        _as.callGlobal(callee->global, first + argc - 1, out, argc, _bail);
+        _as.load(0, out);
+        release(argc + 1);
+    }
+
+    // Stmt visitor
+    void visitExpressionStmt(Expression* stmt) {
+        stmt->expr->accept(this);
+    }
+    void visitFunctionStmt(Function*) {
+        supported = false;
+    }
+    void visitReturnStmt(Return* stmt) {
+        if (stmt->value == nullptr) {
+            supported = false;
+            return;
+        }
+        stmt->value->accept(this);
+        _as.storeResult();
+        _as.jump(Assembler::JMP, _return);
+    }
+    void visitVarStmt(Var* stmt) {
+        if (stmt->storage != Storage::STACK || stmt->initializer == nullptr) {
+            supported = false;
+            return;
+        }
+        stmt->initializer->accept(this);
+        _as.store(stmt->slot);
+    }
+    void visitPrintStmt(Print*) {
+        supported = false;
+    }
+    void visitBlockStmt(Block* stmt) {
+        for (auto* statement : stmt->statements) {
+            statement->accept(this);
+        }
+    }
+    void visitIfStmt(If* stmt) {
+        Label elseBranch{};
+        branch(stmt->condition, false, elseBranch);
+        stmt->thenBranch->accept(this);
+        if (stmt->elseBranch == nullptr) {
+            _as.bind(elseBranch);
+            return;
+        }
+        Label end{};
+        _as.jump(Assembler::JMP, end);
+        _as.bind(elseBranch);
+        stmt->elseBranch->accept(this);
+        _as.bind(end);
+    }
+    void visitWhileStmt(While* stmt) {
+        Label start{}, exit{};
+        _as.bind(start);
+        branch(stmt->expr, false, exit);
+        stmt->body->accept(this);
+        _as.jump(Assembler::JMP, start);
+        _as.bind(exit);
+    }
+
+private:
+    Assembler _as;
+    Label _bail;
+    Label _return;
+    // Slots in use and the most ever used
+    int _next = 0;
+    int _slots = 0;
+
+    int reserve(int count) {
+        int first = _next;
+        _next += count;
+        _slots = std::max(_slots, _next);
+        return first;
+    }
+    void release(int count) {_next -= count;}
+
+    // Left operand in xmm0, right one in xmm1
+    void operands(Binary* b) {
+        b->left->accept(this);
+        int left = reserve(1);
+        _as.store(left);
+        b->right->accept(this);
+        _as.moveToXmm1();
+        _as.load(0, left);
+        release(1);
+    }
+
+    // Jump to `target` when `condition` is `when`. A NaN operand makes every
+    // comparison but != false, as it does for doubles.
+    void branch(Expr* condition, bool when, Label& target) {
+        switch (condition->kind) {
+        case ExprKind::GROUPING:
+            branch(static_cast<Grouping*>(condition)->expression, when, target);
+            return;
+        case ExprKind::UNARY: {
+            auto* unary = static_cast<Unary*>(condition);
+            if (unary->op != TokenType::BANG) break;
+            branch(unary->expression, !when, target);
+            return;
+        }
+        case ExprKind::LOGICAL: {
+            // Only one outcome of the left operand decides
+            auto* logical = static_cast<Logical*>(condition);
+            bool decides = logical->op == TokenType::OR;
+            if (decides == when) {
+                branch(logical->left, when, target);
+                branch(logical->right, when, target);
+            } else {
+                Label skip{};
+                branch(logical->left, decides, skip);
+                branch(logical->right, when, target);
+                _as.bind(skip);
+            }
+            return;
+        }
+        case ExprKind::LITERAL: {
+            auto* literal = static_cast<Literal*>(condition);
+            if (!literal->value.isBool()) break;
+            if (literal->value.asBool() == when) _as.jump(Assembler::JMP, target);
+            return;
+        }
+        default:
+            break;
+        }
+        auto* binary = condition->kind == ExprKind::BINARY ? static_cast<Binary*>(condition) : nullptr;
+        if (binary == nullptr || !isComparison(binary->op)) {
+            // Numbers are always truthy
+            condition->accept(this);
+            if (when) _as.jump(Assembler::JMP, target);
+            return;
+        }
+
+        operands(binary);
+        switch (binary->op) {
+        case TokenType::GREATER:
+            _as.compare(false);
+            _as.jump(when ? Assembler::JA : Assembler::JBE, target);
+            break;
+        case TokenType::GREATER_EQUAL:
+            _as.compare(false);
+            _as.jump(when ? Assembler::JAE : Assembler::JB, target);
+            break;
+        case TokenType::LESS:
+            _as.compare(true);
+            _as.jump(when ? Assembler::JA : Assembler::JBE, target);
+            break;
+        case TokenType::LESS_EQUAL:
+            _as.compare(true);
+            _as.jump(when ? Assembler::JAE : Assembler::JB, target);
+            break;
+        default: {
+            // Equal is ZF set with PF clear, unordered sets both
+            _as.compare(false);
+            bool equal = (binary->op == TokenType::EQUAL_EQUAL) == when;
+            if (equal) {
+                Label skip{};
+                _as.jump(Assembler::JP, skip);
+                _as.jump(Assembler::JE, target);
+                _as.bind(skip);
+            } else {
+                _as.jump(Assembler::JNE, target);
+                _as.jump(Assembler::JP, target);
+            }
+            break;
+        }
+        }
+    }
+
+    static bool isComparison(TokenType op) {
+        return op == TokenType::GREATER || op == TokenType::GREATER_EQUAL || op == TokenType::LESS ||
+            op == TokenType::LESS_EQUAL || op == TokenType::EQUAL_EQUAL || op == TokenType::BANG_EQUAL;
+    }
+};
+
+#endif
+
+} // anonymous namespace
+
+Jit::~Jit() {
+#ifdef LOX_JIT_X86_64
+    for (auto& region : _regions) munmap(region.memory, region.size);
+#endif
+    for (auto* code : _code) delete code;
+}
+
+bool Jit::run(Function* function, const Value* args, size_t argc, Value& result) {
+    if (!enabled) return false;
+    if (function->jit == nullptr) {
+        if (++function->calls < THRESHOLD) return false;
+        function->jit = compile(function);
+    }
+
+    auto* code = function->jit;
+    if (code->entry == nullptr || argc != function->params.size()) return false;
+    double numbers[256];
+    for (size_t i = 0; i < argc; i++) {
+        if (!args[i].isNumber()) return false;
+        numbers[i] = args[i].asNumber();
+    }
+
+    double out;
+    if (code->entry(numbers, &out) != 0) {
+        // Nothing happened yet, the interpreter starts the call over
+        if (++code->bails == MAX_BAILS) code->entry = nullptr;
+        return false;
+    }
+    result = Value::number(out);
+    return true;
+}
+
+void Jit::verify(Function* function, const Value& compiled, const Value& interpreted) {
+    if (compiled == interpreted) return;
+    if (compiled.isNumber() && interpreted.isNumber() && std::isnan(compiled.asNumber()) &&
+        std::isnan(interpreted.asNumber())) {
+        return;
+    }
+    std::cerr << "JIT mismatch in '" << function->name.text() << "': compiled "
+        << Interpreter::stringify(compiled) << ", interpreted " << Interpreter::stringify(interpreted) << std::endl;
+    Lox::hadRuntimeError = true;
+}
+
+// Functions outside the supported subset get a JitCode without an entry, so
+// they are only looked at once
+JitCode* Jit::compile(Function* function) {
+    auto* code = new JitCode{};
+    _code.push_back(code);
+#ifdef LOX_JIT_X86_64
+    if (function->params.size() > 256) return code;
+    JitCompiler compiler{};
+    auto machineCode = compiler.compile(function);
+    if (compiler.supported) code->entry = reinterpret_cast<JitCode::Entry>(install(machineCode));
+#endif
+    return code;
+}
+
+void* Jit::install(const std::vector<uint8_t>& code) {
+#ifdef LOX_JIT_X86_64
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = (code.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    _regions.push_back(Region{memory, size});
+    return memory;
+#else
+    (void)code;
+    return nullptr;
+#endif
+}
+
+} // Lox namespace
@@ -6,26 +6,60 @@ bool Lox::hadError = false;
 bool Lox::hadRuntimeError = false;
 
 Interpreter Lox::interpreter{};
+VM Lox::vm{&Lox::interpreter};
+ClosureEngine Lox::closureEngine{&Lox::interpreter};
+Jit Lox::jit{};
+Options Lox::options{};
 
 void Lox::main(std::vector<std::string>& args) {
-    if(args.size() > 1){
-        std::cout << "Usage: jlox [script]" << std::endl;
-    } else if(args.size() == 1){
-        Lox::runFile(args[0]);
+    // Options come first, anything else is a script path
+    std::vector<std::string> paths{};
+    for (auto& arg : args) {
+        if (arg.rfind("--", 0) == 0) {
+            if (!options.parse(arg)) {
+                std::cout << Options::usage() << std::endl;
+                return;
+            }
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    jit.enabled = options.jit;
+    jit.check = options.jitCheck;
+
+    if(paths.size() > 1){
+        std::cout << Options::usage() << std::endl;
+    } else if(paths.size() == 1){
+        Lox::runFile(paths[0]);
     } else {
         Lox::runPrompt();
     }
 }
 
 void Lox::runFile(std::string& path) {
-    std::fstream file(path);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << path << std::endl;
-        return;
+    if (options.stream) {
+        // Only one window of the script is in memory at a time
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file: " << path << std::endl;
+            return;
+        }
+        StreamingScanner scanner{file, options.streamWindow};
+        run(scanner);
+    } else {
+        // The scanner reads straight out of the mapped file
+        auto source = SourceBuffer::fromFile(path);
+        if (source == nullptr) {
+            std::cerr << "Failed to open file: " << path << std::endl;
+            return;
+        }
+        if (options.scanThreads > 1) {
+            ParallelScanner scanner{source, options.scanThreads};
+            run(scanner);
+        } else {
+            run(source);
+        }
     }
-    std::string source((std::istreambuf_iterator<char>(file)),
-                        std::istreambuf_iterator<char>());
-    run(source);
 
     if (Lox::hadError) {
         std::exit(65);
@@ -42,33 +76,64 @@ void Lox::runPrompt(){
         std::string line;
         std::getline(std::cin, line);
         if (line.empty()) break;
-        run(line);
+        run(std::make_shared<const SourceBuffer>(std::move(line)));
         Lox::hadError = false;
     }
 }
 
-void Lox::run(std::string& source) {
-    // Move through the provided source and create a list of tokens
+void Lox::run(std::shared_ptr<const SourceBuffer> source) {
+    // The scanner only produces compact tokens that point back into the
+    // source, and only as fast as the parser asks for them
     Scanner scanner{source};
-    std::list<Token> tokens = scanner.scanTokens();
+    run(scanner);
+}
 
+void Lox::run(TokenSource& tokens) {
     // Parse those tokens into statements
     Parser parser{tokens};
-    auto statements = parser.parse();
+    if (options.lazy) parser.deferBodies(options.lazyCheck);
+    auto program = parser.parse();
 
     if (hadError) return;
     // Static analysis
     auto resolver = Resolver{&Lox::interpreter};
-    resolver.resolve(statements);
+    resolver.resolve(*program);
 
     if (hadError) return;
 
     // Run the expression to generate side-effects
-    Lox::interpreter.interpret(statements);
+    if (options.engine == Engine::VM) {
+        Lox::vm.interpret(*program);
+    } else if (options.engine == Engine::CLOSURE) {
+        Lox::closureEngine.interpret(*program);
+    } else {
+        Lox::interpreter.interpret(*program);
+    }
+    _programs.push_back(std::move(program));
 
 
 }
 
+void Lox::compileDeferred(Function* function) {
+    auto& deferred = *function->deferred;
+    auto text = deferred.program->source->view().substr(deferred.offset, deferred.length);
+
+    // The whole script was scanned once already, so there are no scanner
+    // errors left to find in here
+    Scanner scanner{text, deferred.line};
+    Parser parser{scanner};
+    parser.parseDeferred(function);
+    if (!hadError) {
+        auto resolver = Resolver{&Lox::interpreter};
+        resolver.resolveDeferred(function);
+    }
+
+    if (hadError) {
+        throw RuntimeError{deferred.line, "Could not compile function '" + std::string{function->name.text()} + "'."};
+    }
+    function->deferred = nullptr;
+}
+
 void Lox::error(const int line,const std::string& message) {
     report(line, std::string(""), message);
 }
@@ -77,13 +142,13 @@ void Lox::error(const Token& token, const std::string& message) {
     if (token.type == TokenType::END) {
         report(token.line, " at end", message);
     } else {
-        report(token.line, " at '" + token.lexeme + "'", message);
+        report(token.line, " at '" + std::string{token.text()} + "'", message);
 
     }
 }
 
 void Lox::runtimeError(RuntimeError& error) {
-    std::cerr<<error.what()<<"\n["<<error.op.line<<"]";
+    std::cerr<<error.what()<<"\n["<<error.line<<"]";
     hadRuntimeError = true;
 }
 
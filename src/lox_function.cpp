@@ -2,37 +2,24 @@
 
 namespace Lox {
 
-LoxFunction::LoxFunction(Function* declaration, std::shared_ptr<Environment>& closure) 
-: declaration{declaration}, closure{closure}
+LoxFunction::LoxFunction(Function* declaration, Upvalues upvalues)
+: declaration{declaration}, upvalues{std::move(upvalues)}
 {}
 
 int LoxFunction::arity() {
     return declaration->params.size();
 }
 
-Value LoxFunction::call(Interpreter* interpreter, std::list<Value>& arguments) {
-    auto env = std::make_shared<Environment>(closure);
-
-    // Messy-ish way to "zip" the list of parameters and args together so we can
-    // easily operate on them together
-    auto _null = std::list<bool>{};
-    std::transform(
-        declaration->params.begin(), declaration->params.end(),
-        arguments.begin(),
-        std::back_inserter(_null),
-        [&](const auto& param, const auto& arg){
-            env->define(param.lexeme,arg);
-            return true;
-        }
-    );
-
-    try {
-        interpreter->executeBlock(declaration->body,env);
-    } catch(const ReturnValue& return_value) {
-        return return_value.value;
-    }
-    
-    return Value{std::monostate{}};
+Value LoxFunction::call(Interpreter* interpreter, size_t argc) {
+    if (declaration->deferred != nullptr) Lox::compileDeferred(declaration);
+
+    Value jitted;
+    bool ran = Lox::jit.run(declaration, interpreter->arguments(argc), argc, jitted);
+    if (ran && !Lox::jit.check) return jitted;
+
+    Value result = interpreter->executeCall(declaration,upvalues,argc);
+    if (ran) Lox::jit.verify(declaration, jitted, result);
+    return result;
 }
 
 
@@ -0,0 +1,138 @@
+#include "../include/lox_string.hpp"
+#include "../include/string_table.hpp"
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace Lox {
+
+//==============================================================================
+// Allocation
+//==============================================================================
+// The characters are followed by a terminating zero, for anything that
+// wants a C string
+LoxString* LoxString::allocate(size_t length) {
+    void* memory = ::operator new(sizeof(LoxString) + length + 1);
+    auto* string = new (memory) LoxString{length};
+    string->buffer()[length] = '\0';
+    string->_chars = string->buffer();
+    return string;
+}
+
+LoxString* LoxString::make(std::string_view chars) {
+    auto* string = allocate(chars.size());
+    std::memcpy(string->buffer(), chars.data(), chars.size());
+    return string;
+}
+
+// A rope is never shorter than ROPE_MINIMUM, so a short result only ever
+// copies flat operands
+LoxString* LoxString::concatenate(LoxString* left, LoxString* right) {
+    if (left->_length == 0) return right;
+    if (right->_length == 0) return left;
+
+    size_t length = left->_length + right->_length;
+    if (length < ROPE_MINIMUM) {
+        auto* string = allocate(length);
+        std::memcpy(string->buffer(), left->chars(), left->_length);
+        std::memcpy(string->buffer() + left->_length, right->chars(), right->_length);
+        return string;
+    }
+
+    void* memory = ::operator new(sizeof(LoxString));
+    auto* string = new (memory) LoxString{length};
+    left->refs++;
+    right->refs++;
+    string->_left = left;
+    string->_right = right;
+    return string;
+}
+
+// Ropes built in a loop are as deep as the loop was long, so the halves
+// whose last reference this was are freed from a worklist, not recursively
+void LoxString::free(LoxString* string) {
+    std::vector<LoxString*> pending{};
+    while (true) {
+        for (LoxString* half : {string->_left, string->_right}) {
+            if (half != nullptr && --half->refs == 0) pending.push_back(half);
+        }
+        if (string->_interned == string) {
+            StringTable::remove(string);
+        } else if (string->_interned != nullptr && --string->_interned->refs == 0) {
+            pending.push_back(string->_interned);
+        }
+        if (string->_chars != nullptr && string->_chars != string->buffer()) {
+            delete[] string->_chars;
+        }
+        string->~LoxString();
+        ::operator delete(string);
+
+        if (pending.empty()) break;
+        string = pending.back();
+        pending.pop_back();
+    }
+}
+
+// Copies the leaves in from the right end, with an explicit stack for the
+// same reason as free. A left-leaning rope, which is what appending in a
+// loop builds, keeps the stack at two entries. Halves already flattened
+// through another reference are copied whole.
+void LoxString::flatten() const {
+    char* chars = new char[_length + 1];
+    chars[_length] = '\0';
+    size_t end = _length;
+
+    std::vector<const LoxString*> stack{_left, _right};
+    while (!stack.empty()) {
+        const LoxString* node = stack.back();
+        stack.pop_back();
+        if (node->_chars != nullptr) {
+            end -= node->_length;
+            std::memcpy(chars + end, node->_chars, node->_length);
+        } else {
+            stack.push_back(node->_left);
+            stack.push_back(node->_right);
+        }
+    }
+
+    _chars = chars;
+    LoxString* halves[] = {_left, _right};
+    _left = nullptr;
+    _right = nullptr;
+    for (LoxString* half : halves) {
+        if (--half->refs == 0) free(half);
+    }
+}
+
+//==============================================================================
+// Comparison
+//==============================================================================
+uint32_t LoxString::computeHash() const {
+    _hash = hashOf(view());
+    _hashed = true;
+    return _hash;
+}
+
+// FNV-1a
+uint32_t LoxString::hashOf(std::string_view chars) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : chars) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// The first comparison of a string made at runtime. It becomes the
+// interned one itself unless an equal string already is.
+const LoxString* LoxString::intern() const {
+    LoxString* entry = StringTable::intern(const_cast<LoxString*>(this));
+    if (entry != this) {
+        entry->refs++;
+        _interned = entry;
+    }
+    return entry;
+}
+
+} // Lox namespace
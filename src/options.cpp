@@ -0,0 +1,81 @@
+#include "../include/options.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace Lox {
+
+namespace {
+
+// Matches "--name" or "--name=value", leaving the value (if any) in `value`
+bool flag(const std::string& arg, const std::string& name, std::string& value) {
+    if (arg == name) {
+        value.clear();
+        return true;
+    }
+    if (arg.compare(0, name.size() + 1, name + "=") == 0) {
+        value = arg.substr(name.size() + 1);
+        return true;
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+bool Options::parse(const std::string& arg) {
+    std::string value{};
+
+    if (flag(arg, "--stream", value)) {
+        stream = true;
+        if (!value.empty()) {
+            try {
+                streamWindow = std::stoul(value);
+            } catch (...) {
+                return false;
+            }
+        }
+        return streamWindow > 0;
+    }
+
+    if (flag(arg, "--parallel-scan", value)) {
+        scanThreads = std::max(1u, std::thread::hardware_concurrency());
+        if (!value.empty()) {
+            try {
+                scanThreads = static_cast<unsigned>(std::stoul(value));
+            } catch (...) {
+                return false;
+            }
+        }
+        return scanThreads > 0;
+    }
+
+    if (flag(arg, "--lazy", value)) {
+        lazy = true;
+        lazyCheck = value == "check";
+        return value.empty() || lazyCheck;
+    }
+
+    if (flag(arg, "--engine", value)) {
+        if (value == "tree") engine = Engine::TREE;
+        else if (value == "vm") engine = Engine::VM;
+        else if (value == "closure") engine = Engine::CLOSURE;
+        else return false;
+        return true;
+    }
+
+    if (flag(arg, "--jit", value)) {
+        if (value == "on") jit = true;
+        else if (value == "off") jit = false;
+        else if (value == "check") jit = jitCheck = true;
+        else return false;
+        return true;
+    }
+
+    return false;
+}
+
+std::string Options::usage() {
+    return "Usage: jlox [--stream[=WINDOW_BYTES]] [--parallel-scan[=THREADS]] [--lazy[=check]] [--engine=tree|vm|closure] [--jit=on|off|check] [script]";
+}
+
+} // Lox namespace
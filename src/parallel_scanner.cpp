@@ -0,0 +1,123 @@
+#include "../include/parallel_scanner.hpp"
+#include "../include/scanner.hpp"
+#include "../include/thread_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Lox {
+
+ParallelScanner::ParallelScanner(std::shared_ptr<const SourceBuffer> source, unsigned threads, size_t minimumChunkSize) 
+: _source{std::move(source)}, _threads{threads > 0 ? threads : 1}, _minimumChunkSize{std::max<size_t>(1, minimumChunkSize)}
+{}
+
+std::vector<size_t> ParallelScanner::splitPoints(std::string_view source, size_t chunks) {
+    std::vector<size_t> points{0};
+    if (chunks < 2) return points;
+
+    const char* begin = source.data();
+    const char* end = begin + source.length();
+    const char* p = begin;
+    size_t target = source.length() / chunks;
+
+    // Only three bytes change the pre-pass state: '"' opens a string that
+    // runs to the next '"', "//" opens a comment that runs to the next '\n',
+    // and a '\n' seen outside of both is a safe place to cut.
+    while (p < end && points.size() < chunks) {
+        while (p < end && *p != '"' && *p != '/' && *p != '\n') p++;
+        if (p == end) break;
+
+        char c = *p++;
+        if (c == '"') {
+            auto* close = static_cast<const char*>(std::memchr(p, '"', end - p));
+            p = close == nullptr ? end : close + 1;
+        } else if (c == '/') {
+            if (p < end && *p == '/') {
+                // Stop on the newline so it is considered as a cut
+                auto* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+                p = newline == nullptr ? end : newline;
+            }
+        } else {
+            size_t offset = p - begin;
+            if (offset >= target && offset < source.length()) {
+                points.push_back(offset);
+                target = source.length() / chunks * points.size();
+            }
+        }
+    }
+
+    return points;
+}
+
+std::vector<CompactToken> ParallelScanner::scanCompactTokens() {
+    scan();
+    for (auto& error : _errors) {
+        Lox::error(error.line, error.message);
+    }
+    _errors.clear();
+    return std::move(_tokens);
+}
+
+CompactToken ParallelScanner::next() {
+    if (!_scanned) scan();
+
+    while (_nextError < _errors.size() && _errors[_nextError].token <= _nextToken) {
+        Lox::error(_errors[_nextError].line, _errors[_nextError].message);
+        _nextError++;
+    }
+
+    if (_nextToken + 1 < _tokens.size()) return _tokens[_nextToken++];
+    return _tokens.back();
+}
+
+void ParallelScanner::scan() {
+    _scanned = true;
+    auto source = _source->view();
+    size_t chunks = std::max<size_t>(1, std::min<size_t>(_threads * 4, source.length() / _minimumChunkSize));
+
+    auto points = chunks > 1 && _threads > 1 ? splitPoints(source, chunks) : std::vector<size_t>{0};
+    points.push_back(source.length());
+
+    // Every chunk is scanned as if it started on line 1
+    std::vector<Scanner> scanners{};
+    scanners.reserve(points.size() - 1);
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        scanners.emplace_back(source.substr(points[i], points[i+1] - points[i]), 1);
+        scanners.back().holdErrors();
+    }
+
+    if (scanners.size() == 1) {
+        scanners.front().scanPrefix(true);
+    } else {
+        ThreadPool pool{std::min<unsigned>(_threads, scanners.size())};
+        for (auto& scanner : scanners) {
+            pool.submit([&scanner]() { scanner.scanPrefix(true); });
+        }
+        pool.wait();
+    }
+
+    // Stitch: shift offsets to the whole source, lines past the lines of the
+    // chunks before and error positions past the tokens before
+    size_t total = 1;
+    for (auto& scanner : scanners) total += scanner.tokens().size();
+    _tokens.clear();
+    _tokens.reserve(total);
+
+    int lineBase = 0;
+    for (size_t i = 0; i < scanners.size(); i++) {
+        auto& scanner = scanners[i];
+        auto offset = static_cast<uint32_t>(points[i]);
+        for (auto& error : scanner.errors()) {
+            _errors.push_back(ScanError{error.token + _tokens.size(), error.line + lineBase, error.message});
+        }
+        for (auto token : scanner.tokens()) {
+            token.offset += offset;
+            token.line += lineBase;
+            _tokens.push_back(token);
+        }
+        lineBase += scanner.line() - 1;
+    }
+    _tokens.push_back(CompactToken{TokenType::END, static_cast<uint32_t>(source.length()), 0, lineBase + 1});
+}
+
+} // Lox namespace
@@ -6,46 +6,68 @@ int Parser::MAXIMUM_FUNCTION_ARGS = 255;
 //==============================================================================
 // Constructors
 //==============================================================================
-Parser::Parser(const std::list<Token>& t) : tokens{t.begin(),t.end()}
-{}
-Parser::Parser(const std::vector<Token>& t) : tokens{t}
+Parser::Parser(TokenSource& source) : _source{source}, _ring{}
 {}
 
 //==============================================================================
 // Statement handling
 //==============================================================================
-std::vector<std::unique_ptr<Stmt>> Parser::parse() {
-    auto statements = std::vector<std::unique_ptr<Stmt>>{};
+std::unique_ptr<Program> Parser::parse() {
+    auto program = std::make_unique<Program>();
+    _program = program.get();
+    if (_deferBodies) _program->source = _source.buffer();
+
     while(!isAtEnd()) {
-        statements.push_back(declaration());
+        _statements.push_back(declaration());
     }
 
-    return statements;
+    _program->topLevel = std::move(_statements);
+    _program->statements = ArenaArray<Stmt*>{
+        _program->topLevel.data(), static_cast<uint32_t>(_program->topLevel.size())
+    };
+    _statements = std::vector<Stmt*>{};
+    _program = nullptr;
+    return program;
+}
+
+void Parser::deferBodies(bool checkSyntax) {
+    _deferBodies = true;
+    _checkDeferred = checkSyntax;
 }
 
-std::unique_ptr<Stmt> Parser::statement() {
+void Parser::parseDeferred(Function* function) {
+    _program = function->deferred->program;
+    try {
+        function->body = block();
+    } catch (ParseError&) {
+        // Already reported
+    }
+    _program = nullptr;
+}
+
+Stmt* Parser::statement() {
     if (match({TokenType::IF})) return ifStatement();
     if (match({TokenType::PRINT})) return printStatement();
     if (match({TokenType::RETURN})) return returnStatement();
     if (match({TokenType::FOR})) return forStatement();
     if (match({TokenType::WHILE})) return whileStatement();
-    if (match({TokenType::LEFT_BRACE})) return std::make_unique<Block>(block());
+    if (match({TokenType::LEFT_BRACE})) return make<Block>(block());
 
     return expressionStatement();
 }
 
-std::unique_ptr<Stmt> Parser::ifStatement() {
+Stmt* Parser::ifStatement() {
     consume(TokenType::LEFT_PAREN,"Expect '(' after 'if'.");
-    std::unique_ptr<Expr> condition = expression();
+    Expr* condition = expression();
     consume (TokenType::RIGHT_PAREN, "Expect ')' after if condition.");
 
     auto thenBranch = statement();
-    auto elseBranch = std::unique_ptr<Stmt>{};
+    Stmt* elseBranch = nullptr;
     if (match({TokenType::ELSE})) {
         elseBranch = statement();
     }
 
-    return std::make_unique<If>(
+    return make<If>(
         condition,
         thenBranch,
         elseBranch
@@ -53,17 +75,17 @@ std::unique_ptr<Stmt> Parser::ifStatement() {
 
 }
 
-std::unique_ptr<Stmt> Parser::whileStatement() {
+Stmt* Parser::whileStatement() {
     consume(TokenType::LEFT_PAREN,"Expect '(' after 'while'.");
     auto condition = expression();
 
     consume(TokenType::RIGHT_PAREN,"Expect ')' after condition");
     auto body = statement();
 
-    return std::make_unique<While>(condition,body);
+    return make<While>(condition,body);
 }
 
-std::unique_ptr<Stmt> Parser::forStatement() {
+Stmt* Parser::forStatement() {
     consume(TokenType::LEFT_PAREN,"Expect '(' after 'for'.");
     // Basic structure
     // for(initializer; condition; increment;) {
@@ -71,7 +93,7 @@ std::unique_ptr<Stmt> Parser::forStatement() {
     //  }
 
     // Initializer part of FOR loop
-    std::unique_ptr<Stmt> initializer{};
+    Stmt* initializer{};
     if (match({TokenType::SEMICOLON})) {
         // Immediate semicolon means initializer is omitted
     } else if (match({TokenType::VAR})) {
@@ -81,43 +103,37 @@ std::unique_ptr<Stmt> Parser::forStatement() {
     }
 
     // Condition part
-    std::unique_ptr<Expr> condition{};
+    Expr* condition{};
     if (!check(TokenType::SEMICOLON)) {
         condition = expression();
     }
     consume(TokenType::SEMICOLON, "Expect ';' after loop condition.");
 
     // Increment part
-    std::unique_ptr<Expr> increment{};
+    Expr* increment{};
     if (!check(TokenType::RIGHT_PAREN)) {
         increment = expression();
     }
     consume(TokenType::RIGHT_PAREN, "Expect ')' after for clauses.");
 
     // Body
-    std::unique_ptr<Stmt> body = statement();
-    std::list<std::unique_ptr<Stmt>> stmts;
+    Stmt* body = statement();
     // Desugaring for-loop syntax into lox AST nodes
-    if (increment.get() != nullptr) {
-        stmts.push_back(std::move(body));
-        stmts.push_back(std::make_unique<Expression>(increment));
-        body = std::make_unique<Block>(std::move(stmts));
+    if (increment != nullptr) {
+        body = make<Block>(_program->arena.array<Stmt*>({body, make<Expression>(increment)}));
     }
-    if (condition.get() == nullptr) {
-        condition = std::make_unique<Literal>(true);
+    if (condition == nullptr) {
+        condition = make<Literal>(true);
     }
-    stmts = std::list<std::unique_ptr<Stmt>>{};
-    body = std::make_unique<While>(condition,body);
-    if (initializer.get() != nullptr) {
-        stmts.push_back(std::move(initializer));
-        stmts.push_back(std::move(body));
-        body = std::make_unique<Block>(std::move(stmts));
+    body = make<While>(condition,body);
+    if (initializer != nullptr) {
+        body = make<Block>(_program->arena.array<Stmt*>({initializer, body}));
     }
 
     return body;
 }
 
-std::unique_ptr<Stmt> Parser::declaration() {
+Stmt* Parser::declaration() {
     try {
         if (match({TokenType::FUN})) return function("function");
         if (match({TokenType::VAR})) return varDeclaration();
@@ -129,271 +145,303 @@ std::unique_ptr<Stmt> Parser::declaration() {
 
 }
 
-std::unique_ptr<Stmt> Parser::function(const std::string& kind) {
+Stmt* Parser::function(const std::string& kind) {
     // fun NAME(PARAMETERS...) {
     //    BODY
     //}
 
+    // The messages mention the kind, so they are only built on failure
+
     // NAME
-    auto name = Token{consume(TokenType::IDENTIFIER, "Expect "+kind+" name.")};
+    if (!check(TokenType::IDENTIFIER)) throw error(peek(), "Expect "+kind+" name.");
+    auto functionName = name(advance());
 
     // PARAMETERS
-    consume(TokenType::LEFT_PAREN, "Expect '(' after " + kind + " name.");
-    auto parameters = std::list<Token>{};
+    if (!check(TokenType::LEFT_PAREN)) throw error(peek(), "Expect '(' after " + kind + " name.");
+    advance();
+    // Functions cannot nest inside a parameter list, but an earlier one may
+    // have bailed out half way through its own
+    _parameters.clear();
     if (!check(TokenType::RIGHT_PAREN)) {
         do {
-            if (parameters.size() >= Parser::MAXIMUM_FUNCTION_ARGS) {
+            if (_parameters.size() >= Parser::MAXIMUM_FUNCTION_ARGS) {
                 error(peek(), "Can't have more than "+std::to_string(Parser::MAXIMUM_FUNCTION_ARGS)+" parameters.");
             }
-            auto param = consume(TokenType::IDENTIFIER, "Expect parameter name.");
-            parameters.push_back(param);
+            _parameters.emplace_back(name(consume(TokenType::IDENTIFIER, "Expect parameter name.")));
         } while (match({TokenType::COMMA}));
     }
     consume(TokenType::RIGHT_PAREN, "Expect ')' after parameters.");
+    auto parameters = _program->arena.array(_parameters, 0);
 
     // BODY
-    consume(TokenType::LEFT_BRACE, "Expect '{' before "+kind+" body.");
+    if (!check(TokenType::LEFT_BRACE)) throw error(peek(), "Expect '{' before "+kind+" body.");
+    const CompactToken& brace = advance();
+
+    if (_deferBodies && _depth == 0 && _program->source != nullptr) {
+        auto* deferred = make<DeferredBody>(DeferredBody{_program, brace.offset + 1, 0, brace.line});
+        if (_checkDeferred) {
+            // Parse into a scratch program that is dropped straight away
+            Program scratch{};
+            Program* program = _program;
+            _program = &scratch;
+            try {
+                block();
+            } catch (ParseError&) {
+                _program = program;
+                throw;
+            }
+            _program = program;
+        } else {
+            skipBody();
+        }
+        // previous() is the closing brace
+        deferred->length = previous().offset + 1 - deferred->offset;
+
+        auto* function = make<Function>(std::move(functionName),parameters,ArenaArray<Stmt*>{});
+        function->deferred = deferred;
+        return function;
+    }
+
     auto body = block();
 
-    return std::make_unique<Function>(name,parameters,body);
+    return make<Function>(std::move(functionName),parameters,body);
+}
+
+// Step over a function body up to and including its closing brace
+void Parser::skipBody() {
+    int depth = 1;
+    while (true) {
+        if (isAtEnd()) throw error(peek(), "Expect '}' after block.");
+        TokenType type = advance().type;
+        if (type == TokenType::LEFT_BRACE) {
+            depth++;
+        } else if (type == TokenType::RIGHT_BRACE && --depth == 0) {
+            return;
+        }
+    }
 }
 
-std::unique_ptr<Stmt> Parser::varDeclaration() {
+Stmt* Parser::varDeclaration() {
     // Once we reconginze a var, we need to find the identifier or throw
-    auto name = consume(TokenType::IDENTIFIER, "Expect variable name");
+    auto variable = name(consume(TokenType::IDENTIFIER, "Expect variable name"));
     
     // If there is some kind of initializer, get it after the equals sign.
-    std::unique_ptr<Expr> initializer{};
+    Expr* initializer{};
     if (match({TokenType::EQUAL})) {
         initializer = expression();
     }
 
     // Search for the end of the statement or throw
     consume(TokenType::SEMICOLON, "Expect ';' after variable declaration");
-    return std::make_unique<Var>(name,initializer);
+    return make<Var>(std::move(variable),initializer);
 }
 
-std::unique_ptr<Stmt> Parser::printStatement() {
+Stmt* Parser::printStatement() {
     auto value = expression();
     consume(TokenType::SEMICOLON,"Expect ';' after value.");
-    return std::make_unique<Print>(value);
+    return make<Print>(value);
 }
 
-std::unique_ptr<Stmt> Parser::returnStatement() {
-    Token keyword = previous();
+Stmt* Parser::returnStatement() {
+    int line = previous().line;
 
-    std::unique_ptr<Expr> value{};
+    Expr* value{};
     if (!check(TokenType::SEMICOLON)) {
         value = expression();
     }
 
     consume(TokenType::SEMICOLON, "Expect ';' after return value.");
-    return std::make_unique<Return>(keyword,value);
+    return make<Return>(line,value);
 
 }
 
-std::unique_ptr<Stmt> Parser::expressionStatement() {
+Stmt* Parser::expressionStatement() {
     auto expr = expression();
     consume(TokenType::SEMICOLON, "Expect ';' after expression.");
-    return std::make_unique<Expression>(expr);
+    return make<Expression>(expr);
 }
 
-std::list<std::unique_ptr<Stmt>> Parser::block() {
-    auto statements = std::list<std::unique_ptr<Stmt>>{};
+ArenaArray<Stmt*> Parser::block() {
+    // Nested blocks stack their statements on top of this one's
+    size_t start = _statements.size();
 
+    // declaration() never throws, so there is no way out of the loop that
+    // would skip the decrement
+    _depth++;
     while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
-        statements.push_back(declaration());
+        _statements.push_back(declaration());
     }
+    _depth--;
 
-    consume(TokenType::RIGHT_BRACE,"Expect '}' after block.");
-    return statements;
+    try {
+        consume(TokenType::RIGHT_BRACE,"Expect '}' after block.");
+    } catch (ParseError&) {
+        _statements.resize(start);
+        throw;
+    }
+    return _program->arena.array(_statements, start);
 }
 
 //==============================================================================
 // Expression handling
 //==============================================================================
-std::unique_ptr<Expr> Parser::expression() {
-    return assignment();
-}
-
-std::unique_ptr<Expr> Parser::assignment() {
-    auto expr = or_expression();
-
-    if (match({TokenType::EQUAL})) {
-        auto equals = previous();
-        auto value = assignment();
-
-        if (Variable* v = dynamic_cast<Variable*>(expr.get())) {
-            auto name = v->name;
-            return std::make_unique<Assign>(name,value);
-        }
-
-        Lox::error(equals,"Invalid assignment target.");
-    }
-
-    return expr;
-}
+constexpr std::array<Parser::ParseRule, Parser::TOKEN_TYPES> Parser::makeRules() {
+    std::array<ParseRule, TOKEN_TYPES> rules{};
+    for (auto& rule : rules) rule = ParseRule{nullptr, nullptr, Precedence::NONE};
+
+    auto set = [&](TokenType type, ParseRule rule) {
+        rules[static_cast<size_t>(type)] = rule;
+    };
+
+    set(TokenType::LEFT_PAREN,    {&Parser::grouping, &Parser::finishCall, Precedence::CALL});
+    set(TokenType::MINUS,         {&Parser::unary, &Parser::binary, Precedence::TERM});
+    set(TokenType::PLUS,          {nullptr, &Parser::binary, Precedence::TERM});
+    set(TokenType::SLASH,         {nullptr, &Parser::binary, Precedence::FACTOR});
+    set(TokenType::STAR,          {nullptr, &Parser::binary, Precedence::FACTOR});
+    set(TokenType::BANG,          {&Parser::unary, nullptr, Precedence::NONE});
+    set(TokenType::BANG_EQUAL,    {nullptr, &Parser::binary, Precedence::EQUALITY});
+    set(TokenType::EQUAL_EQUAL,   {nullptr, &Parser::binary, Precedence::EQUALITY});
+    set(TokenType::GREATER,       {nullptr, &Parser::binary, Precedence::COMPARISON});
+    set(TokenType::GREATER_EQUAL, {nullptr, &Parser::binary, Precedence::COMPARISON});
+    set(TokenType::LESS,          {nullptr, &Parser::binary, Precedence::COMPARISON});
+    set(TokenType::LESS_EQUAL,    {nullptr, &Parser::binary, Precedence::COMPARISON});
+    set(TokenType::EQUAL,         {nullptr, &Parser::assignment, Precedence::ASSIGNMENT});
+    set(TokenType::AND,           {nullptr, &Parser::logical, Precedence::AND});
+    set(TokenType::OR,            {nullptr, &Parser::logical, Precedence::OR});
+    set(TokenType::IDENTIFIER,    {&Parser::variable, nullptr, Precedence::NONE});
+    set(TokenType::STRING,        {&Parser::literal, nullptr, Precedence::NONE});
+    set(TokenType::NUMBER,        {&Parser::literal, nullptr, Precedence::NONE});
+    set(TokenType::FALSE,         {&Parser::literal, nullptr, Precedence::NONE});
+    set(TokenType::TRUE,          {&Parser::literal, nullptr, Precedence::NONE});
+    set(TokenType::NIL,           {&Parser::literal, nullptr, Precedence::NONE});
+
+    return rules;
+}
+
+const Parser::ParseRule& Parser::rule(TokenType type) {
+    static constexpr auto RULES = makeRules();
+    return RULES[static_cast<size_t>(type)];
+}
+
+Expr* Parser::expression() {
+    return parsePrecedence(Precedence::ASSIGNMENT);
+}
+
+// Parse an expression whose operators all bind at least as tightly as
+// `precedence`. Left associative operators parse their right operand one
+// level up, so chains like a + b + c are handled by the loop, not recursion.
+Expr* Parser::parsePrecedence(Precedence precedence) {
+    auto prefix = rule(peek().type).prefix;
+    if (prefix == nullptr) throw error(peek(), "Expect expression.");
+    advance();
+    Expr* expr = (this->*prefix)();
 
-std::unique_ptr<Expr> Parser::equality() {
-    std::unique_ptr<Expr> expr = comparison();
-    while(match({TokenType::BANG_EQUAL,TokenType::EQUAL_EQUAL})) {
-        Token op = previous();
-        std::unique_ptr<Expr> right = comparison();
-        expr = std::make_unique<Binary>(std::move(expr),op,std::move(right));
+    while (true) {
+        auto& infix = rule(peek().type);
+        if (infix.precedence < precedence || infix.infix == nullptr) break;
+        advance();
+        expr = (this->*infix.infix)(expr);
     }
 
     return expr;
 }
 
-std::unique_ptr<Expr> Parser::or_expression() {
-    auto expr = and_expression();
-
-    while (match({TokenType::OR})) {
-        Token op = previous();
-        auto right = and_expression();
-        expr = std::make_unique<Logical>(expr,op,right);
-    }
-
-    return expr;
-
+Expr* Parser::grouping() {
+    Expr* expr = expression();
+    consume(TokenType::RIGHT_PAREN, "Expect ')' after expression.");
+    return make<Grouping>(expr);
 }
 
-std::unique_ptr<Expr> Parser::and_expression() {
-    auto expr = equality();
-    
-    while(match({TokenType::AND})) {
-        Token op = previous();
-        auto right = equality();
-        expr = std::make_unique<Logical>(expr,op,right);
+Expr* Parser::literal() {
+    switch (previous().type)
+    {
+    case TokenType::FALSE: return make<Literal>(false);
+    case TokenType::TRUE: return make<Literal>(true);
+    case TokenType::NIL: return make<Literal>(Value{});
+    default: return make<Literal>(_source.literal(previous()));
     }
-
-    return expr;
-
 }
 
-std::unique_ptr<Expr> Parser::comparison() {
-    std::unique_ptr<Expr> expr = term();
-
-    while(match({
-                    TokenType::GREATER,
-                    TokenType::GREATER_EQUAL,
-                    TokenType::LESS,
-                    TokenType::LESS_EQUAL
-                })) {
-        Token op = previous();
-        std::unique_ptr<Expr> right = term();
-        expr = std::make_unique<Binary>(std::move(expr),op,std::move(right));
-    }
-
-    return expr;
+Expr* Parser::variable() {
+    return make<Variable>(name(previous()));
 }
 
-std::unique_ptr<Expr> Parser::term() {
-    std::unique_ptr<Expr> expr = factor();
-
-    while(match({TokenType::MINUS,TokenType::PLUS})) {
-        Token op = previous();
-        std::unique_ptr<Expr> right = factor();
-        expr = std::make_unique<Binary>(std::move(expr),op,std::move(right));
-    }
-
-    return expr;
+Expr* Parser::unary() {
+    CompactToken op = previous();
+    Expr* right = parsePrecedence(Precedence::UNARY);
+    return make<Unary>(op.type,op.line,right);
 }
 
-std::unique_ptr<Expr> Parser::factor() {
-    std::unique_ptr<Expr> expr = unary();
-
-    while(match({TokenType::SLASH,TokenType::STAR})) {
-        Token op = previous();
-        std::unique_ptr<Expr> right = unary();
-        expr = std::make_unique<Binary>(std::move(expr),op,std::move(right));
-    }
-
-    return expr;
+Expr* Parser::binary(Expr* left) {
+    CompactToken op = previous();
+    auto precedence = static_cast<int>(rule(op.type).precedence);
+    Expr* right = parsePrecedence(static_cast<Precedence>(precedence + 1));
+    return make<Binary>(left,op.type,op.line,right);
 }
 
-std::unique_ptr<Expr> Parser::unary() {
-    if (match({TokenType::BANG,TokenType::MINUS})) {
-        Token op = previous();
-        std::unique_ptr<Expr> right = unary();
-        return std::make_unique<Unary>(op,std::move(right));
-    }
-    return call();
+Expr* Parser::logical(Expr* left) {
+    TokenType op = previous().type;
+    auto precedence = static_cast<int>(rule(op).precedence);
+    Expr* right = parsePrecedence(static_cast<Precedence>(precedence + 1));
+    return make<Logical>(left,op,right);
 }
 
-std::unique_ptr<Expr> Parser::primary() {
-    if (match({TokenType::FALSE})) return std::make_unique<Literal>(false);
-    if (match({TokenType::TRUE})) return std::make_unique<Literal>(true);
-    if (match({TokenType::NIL})) return std::make_unique<Literal>(std::monostate{});
-
-    if (match({TokenType::NUMBER,TokenType::STRING})) {
-        return std::make_unique<Literal>(Value{previous().literal});
-    }
+// Right associative: a = b = c assigns c to b first
+Expr* Parser::assignment(Expr* target) {
+    // The ring may have moved past the '=' by the time it is reported
+    int line = previous().line;
+    Expr* value = parsePrecedence(Precedence::ASSIGNMENT);
 
-    if (match({TokenType::IDENTIFIER})) {
-        return std::make_unique<Variable>(previous());
-    }
-    
-    if (match({TokenType::LEFT_PAREN})) {
-        std::unique_ptr<Expr> expr = expression();
-        consume(TokenType::RIGHT_PAREN, "Expect ')' after expression.");
-        return std::make_unique<Grouping>(std::move(expr));
+    if (target->kind == ExprKind::VARIABLE) {
+        return make<Assign>(std::move(static_cast<Variable*>(target)->name),value);
     }
 
-    throw error(peek(), "Expect expression.");
-
+    Lox::error(Token{TokenType::EQUAL, "=", Value{}, line},"Invalid assignment target.");
+    return target;
 }
 
-std::unique_ptr<Expr> Parser::call() {
-    auto expr = primary();
+Expr* Parser::finishCall(Expr* callee) {
+    // Calls nested in the arguments stack theirs on top of these
+    size_t start = _arguments.size();
 
-    while(true) {
-        if (match({TokenType::LEFT_PAREN})) {
-            expr = finishCall(expr);
-        } else {
-            break;
+    try {
+        if (!check(TokenType::RIGHT_PAREN)) {
+            do {
+                if (_arguments.size() - start > Parser::MAXIMUM_FUNCTION_ARGS) {
+                    error(peek(),"Can't have more than "+std::to_string(Parser::MAXIMUM_FUNCTION_ARGS)+" arguments.");
+                }
+                _arguments.push_back(expression());
+            } while (match({TokenType::COMMA}));
         }
-    }
 
-    return expr;
-}
-
-std::unique_ptr<Expr> Parser::finishCall(std::unique_ptr<Expr>& callee) {
-    std::list<std::unique_ptr<Expr>> args{};
-
-    if (!check(TokenType::RIGHT_PAREN)) {
-        do {
-            if (args.size() > Parser::MAXIMUM_FUNCTION_ARGS) {
-                error(peek(),"Can't have more than "+std::to_string(Parser::MAXIMUM_FUNCTION_ARGS)+" arguments.");
-            }
-            args.push_back(expression());
-        } while (match({TokenType::COMMA}));
+        int line = consume(TokenType::RIGHT_PAREN, "Expect ')' after arguments").line;
+        return make<Call>(callee,line,_program->arena.array(_arguments, start));
+    } catch (ParseError&) {
+        _arguments.resize(start);
+        throw;
     }
-
-    Token paren = consume(TokenType::RIGHT_PAREN, "Expect ')' after arguments");
-
-    return std::make_unique<Call>(callee,paren,args);
 }
 
 //==============================================================================
 // Error handling
 //==============================================================================
-Token Parser::consume(const TokenType& type, const std::string& message) {
+const CompactToken& Parser::consume(TokenType type, std::string_view message) {
     if (check(type)) return advance();
     throw error(peek(),message);
 }
 
-ParseError Parser::error(const Token& token, const std::string& message) {
-    Lox::error(token,message);
+// The token is only materialized here, on the error path
+ParseError Parser::error(const CompactToken& token, std::string_view message) {
+    Lox::error(_source.materialize(token),std::string{message});
     return ParseError{};
 }
 
 void Parser::synchronize() {
     advance();
     while(!isAtEnd()) {
-        if (previous().type == TokenType::SEMICOLON) return;
+        if (at(current-1).type == TokenType::SEMICOLON) return;
 
-        switch (peek().type)
+        switch (at(current).type)
         {
         case TokenType::CLASS:
         case TokenType::FOR:
@@ -427,26 +475,39 @@ bool Parser::match(std::initializer_list<TokenType> types) {
     return false;
 }
 
-bool Parser::check(const TokenType& type) {
+bool Parser::check(TokenType type) {
     if (isAtEnd()) return false;
-    return peek().type == type;
+    return at(current).type == type;
 }
 
-Token Parser::advance() {
+const CompactToken& Parser::advance() {
     if (!isAtEnd()) current++;
     return previous();
 }
 
-Token Parser::peek() {
-    return tokens[current];
+const CompactToken& Parser::peek() {
+    return at(current);
 }
 
-Token Parser::previous() {
-    return tokens[current-1];
+const CompactToken& Parser::previous() {
+    return at(current-1);
 }
 
 bool Parser::isAtEnd() {
-    return peek().type == TokenType::END;
+    return at(current).type == TokenType::END;
+}
+
+const CompactToken& Parser::at(int index) {
+    while (_pulled <= index) {
+        _ring[_pulled++ % _ring.size()] = _source.next();
+    }
+    return _ring[index % _ring.size()];
+}
+
+// The only copy of an identifier's text the parser makes: its interned name,
+// held by the AST
+Token Parser::name(const CompactToken& token) {
+    return _source.materialize(token);
 }
 
 } // Lox namespace
\ No newline at end of file
@@ -2,79 +2,139 @@
 
 namespace Lox {
 
-Resolver::Resolver(Interpreter* interpreter) : interpreter{interpreter}, scopes{}, currentFunction{FunctionType::NONE}
+Resolver::Resolver(Interpreter* interpreter)
+: interpreter{interpreter}, scopes{}, frames{}, arena{nullptr}, currentFunction{FunctionType::NONE}
 {}
 
-void Resolver::resolve(std::vector<std::unique_ptr<Stmt>>& statements) {
-    for (auto& stmt : statements) {
-        resolve(stmt);
-    }
+// Top-level blocks share one frame for the whole program
+void Resolver::resolve(Program& program) {
+    arena = &program.arena;
+    frames.push_back(Frame{});
+    resolve(program.statements);
+    program.frameSize = frames.back().size;
+    program.cells = frames.back().captured ? program.frameSize : 0;
+    frames.pop_back();
 }
 
-void Resolver::resolve(std::list<std::unique_ptr<Stmt>>& statements) {
-    for (auto& stmt : statements) {
+void Resolver::resolve(const ArenaArray<Stmt*>& statements) {
+    for (auto* stmt : statements) {
         resolve(stmt);
     }
 }
 
-
-void Resolver::resolve(std::unique_ptr<Stmt>& stmt) {
+void Resolver::resolve(Stmt* stmt) {
     stmt->accept(this);
 }
 
-void Resolver::resolveLocal(Expr* expr, const Token& name) {
+// Names no scope declares are globals. A local of the same function is on
+// the stack or in a cell, which is only known once its scope ends, so until
+// then the use waits in that scope's reference list.
+void Resolver::resolveLocal(const Token& name, Storage& storage, int& slot, Global*& global) {
+    int frame = frames.size()-1;
     for (int i = scopes.size()-1; i >= 0; i--) {
-        if (scopes[i].find(name.lexeme)!= scopes[i].end()) {
-            interpreter->resolve(expr,scopes.size()-1-i);
-            return;
+        auto local = scopes[i].locals.find(name.literal.asLoxString());
+        if (local == scopes[i].locals.end()) continue;
+
+        if (scopes[i].frame == frame) {
+            slot = local->second.slot;
+            scopes[i].references.push_back(Reference{&local->second, &storage});
+        } else {
+            local->second.captured = true;
+            storage = Storage::UPVALUE;
+            slot = resolveUpvalue(frame, scopes[i].frame, local->second.slot);
         }
+        return;
+    }
+    storage = Storage::GLOBAL;
+    global = interpreter->globals.intern(name.literal);
+}
+
+// Index of the upvalue through which function `frame` reaches cell `slot` of
+// function `owner`. Every function in between captures it too, so it can be
+// handed down when the inner closures are created.
+int Resolver::resolveUpvalue(int frame, int owner, int slot) {
+    Capture capture{true, slot};
+    if (frame - 1 != owner) capture = Capture{false, resolveUpvalue(frame - 1, owner, slot)};
+
+    auto& upvalues = frames[frame].upvalues;
+    for (size_t i = 0; i < upvalues.size(); i++) {
+        if (upvalues[i].local == capture.local && upvalues[i].index == capture.index) return i;
     }
+    upvalues.push_back(capture);
+    return upvalues.size()-1;
 }
 
 void Resolver::resolveFunction(Function* function, const FunctionType& type) {
     auto enclosingFunction = currentFunction;
     currentFunction = type;
 
+    frames.push_back(Frame{});
     beginScope();
     for (auto& param : function->params) {
-        declare(param);
-        define(param);
+        declare(param.name, param.storage, param.slot);
+        define(param.name);
     }
     resolve(function->body);
     endScope();
+    auto& frame = frames.back();
+    function->frameSize = frame.size;
+    function->cells = frame.captured ? frame.size : 0;
+    function->upvalues = arena->array(frame.upvalues, 0);
+    frames.pop_back();
 
     currentFunction = enclosingFunction;
 }
 
-void Resolver::resolve(std::unique_ptr<Expr>& expr) {
+void Resolver::resolve(Expr* expr) {
     expr->accept(this);
 }
 
-void Resolver::declare(const Token& name) {
-    if (scopes.empty()) return;
+// Only for locals; `storage` is filled in when the scope ends
+void Resolver::declare(const Token& name, Storage& storage, int& slot) {
     auto& scope = scopes.back();
-    if (scope.find(name.lexeme) != scope.end()) {
+    auto existing = scope.locals.find(name.literal.asLoxString());
+    if (existing != scope.locals.end()) {
         Lox::error(name, "Already a variable with this name in this scope");
+        existing->second.defined = false;
+        return;
     }
-    scope[name.lexeme] = false;
+    auto& frame = frames.back();
+    slot = frame.next++;
+    scope.locals.emplace(name.literal.asLoxString(), Local{false, slot, false, &storage});
+    frame.size = std::max(frame.size, frame.next);
 }
 
 void Resolver::define(const Token& name) {
     if (scopes.empty()) return;
     auto& scope = scopes.back();
-    scope[name.lexeme] = true;
+    scope.locals.at(name.literal.asLoxString()).defined = true;
 }
 
 void Resolver::beginScope() {
-    scopes.push_back(std::unordered_map<std::string,bool>{});
+    int frame = frames.size()-1;
+    scopes.push_back(Scope{{}, {}, frame, frames.back().next});
 }
 
+// Every use of the scope's locals has been seen by now, so it is settled
+// which of them closures capture
 void Resolver::endScope() {
+    auto& scope = scopes.back();
+    auto& frame = frames.back();
+    for (auto& entry : scope.locals) {
+        auto& local = entry.second;
+        *local.storage = local.captured ? Storage::CELL : Storage::STACK;
+        if (local.captured) frame.captured = true;
+    }
+    for (auto& reference : scope.references) {
+        *reference.storage = *reference.local->storage;
+    }
+
+    frame.next = scope.firstSlot;
     scopes.pop_back();
 }
 
 //==============================================================================
-// ExprVisitor<void>
+// Expr visitor
 //==============================================================================
 void Resolver::visitBinaryExpr(Binary* expr) {
     resolve(expr->left);
@@ -96,16 +156,16 @@ void Resolver::visitLiteralExpr(Literal* expr) {
 
 void Resolver::visitVariableExpr(Variable* expr) {
     if (!scopes.empty() && 
-         scopes.back().find(expr->name.lexeme) != scopes.back().end() && 
-         scopes.back().at(expr->name.lexeme) == false) {
+         scopes.back().locals.find(expr->name.literal.asLoxString()) != scopes.back().locals.end() && 
+         scopes.back().locals.at(expr->name.literal.asLoxString()).defined == false) {
         Lox::error(expr->name, "Can't read local variable in it's own initializer.");
     }
-    resolveLocal(expr, expr->name);
+    resolveLocal(expr->name, expr->storage, expr->slot, expr->global);
 }
 
 void Resolver::visitAssignExpr(Assign* expr) {
     resolve(expr->value);   
-    resolveLocal(expr,expr->name);
+    resolveLocal(expr->name, expr->storage, expr->slot, expr->global);
 }
 
 void Resolver::visitLogicalExpr(Logical* expr) {
@@ -116,33 +176,47 @@ void Resolver::visitLogicalExpr(Logical* expr) {
 void Resolver::visitCallExpr(Call* expr) {
     resolve(expr->callee);
 
-    for (auto& arg : expr->arguments) {
+    for (auto* arg : expr->arguments) {
         resolve(arg);
     }
 }
 
 //==============================================================================
-// StmtVisitor<void>
+// Stmt visitor
 //==============================================================================
 void Resolver::visitExpressionStmt(Expression* stmt) {
     resolve(stmt->expr);
 }
 
 void Resolver::visitFunctionStmt(Function* stmt) {
-    declare(stmt->name);
+    if (scopes.empty()) {
+        stmt->global = interpreter->globals.intern(stmt->name.literal);
+    } else {
+        declare(stmt->name, stmt->storage, stmt->slot);
+    }
     define(stmt->name);
-    resolveFunction(stmt,FunctionType::FUNCTION);
+    // A deferred body is resolved once it has been parsed
+    if (stmt->deferred == nullptr) resolveFunction(stmt,FunctionType::FUNCTION);
+}
+
+void Resolver::resolveDeferred(Function* function) {
+    arena = &function->deferred->program->arena;
+    resolveFunction(function,FunctionType::FUNCTION);
 }
 
 void Resolver::visitReturnStmt(Return* stmt) {
     if (currentFunction == FunctionType::NONE) {
-        Lox::error(stmt->keyword,"Can't return from top-level code.");
+        Lox::error(Token{TokenType::RETURN, "return", Value{}, stmt->line},"Can't return from top-level code.");
     }
     if (stmt->value != nullptr) resolve(stmt->value);
 }
 
 void Resolver::visitVarStmt(Var* stmt) {
-    declare(stmt->name);
+    if (scopes.empty()) {
+        stmt->global = interpreter->globals.intern(stmt->name.literal);
+    } else {
+        declare(stmt->name, stmt->storage, stmt->slot);
+    }
     if (stmt->initializer != nullptr) {
         resolve(stmt->initializer);
     }
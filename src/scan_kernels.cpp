@@ -0,0 +1,301 @@
+#include "../include/scan_kernels.hpp"
+#include "../include/char_class.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LOX_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Lox {
+
+//==============================================================================
+// Scalar kernels. These define the expected results for the vector ones.
+//==============================================================================
+namespace {
+
+const char* scalarWhitespace(const char* p, const char* end, int* newlines) {
+    int lines = 0;
+    while (p < end) {
+        char c = *p;
+        if (c == '\n') {
+            lines++;
+        } else if (!(charClass(c).flags & SPACE)) {
+            break;
+        }
+        p++;
+    }
+    *newlines += lines;
+    return p;
+}
+
+const char* scalarLineRest(const char* p, const char* end) {
+    while (p < end && *p != '\n') p++;
+    return p;
+}
+
+const char* scalarIdentifier(const char* p, const char* end) {
+    while (p < end && isAlphaNumericChar(*p)) p++;
+    return p;
+}
+
+const char* scalarStringBody(const char* p, const char* end, int* newlines) {
+    int lines = 0;
+    while (p < end && *p != '"') {
+        if (*p == '\n') lines++;
+        p++;
+    }
+    *newlines += lines;
+    return p;
+}
+
+const ScanKernels SCALAR_KERNELS{
+    scalarWhitespace, scalarLineRest, scalarIdentifier, scalarStringBody, "scalar"
+};
+
+#ifdef LOX_SCAN_X86
+//==============================================================================
+// SSE2 kernels (16 bytes per step). SSE2 is part of the x86-64 baseline.
+//==============================================================================
+inline unsigned lowBitsBelow(unsigned bit) {
+    return (1u << bit) - 1;
+}
+
+// Most runs in real code are a few bytes long (one space, a short name), so
+// the vector kernels look at the first few bytes one at a time before paying
+// for a full vector load.
+constexpr int SHORT_RUN = 4;
+
+inline __m128i identifierMask16(__m128i chunk) {
+    // Folding to lower case maps A-Z onto a-z and nothing else onto a-z
+    __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    __m128i alpha = _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+        _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(
+        _mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+    __m128i underscore = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+}
+
+const char* sse2Whitespace(const char* p, const char* end, int* newlines) {
+    for (int i = 0; i < SHORT_RUN && p < end; i++, p++) {
+        if (*p == '\n') {
+            (*newlines)++;
+        } else if (!(charClass(*p).flags & SPACE)) {
+            return p;
+        }
+    }
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i nl = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+        __m128i space = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), nl));
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(space)) & 0xFFFF;
+        unsigned lines = static_cast<unsigned>(_mm_movemask_epi8(nl));
+        if (stop) {
+            unsigned at = __builtin_ctz(stop);
+            *newlines += __builtin_popcount(lines & lowBitsBelow(at));
+            return p + at;
+        }
+        *newlines += __builtin_popcount(lines);
+        p += 16;
+    }
+    return scalarWhitespace(p, end, newlines);
+}
+
+const char* sse2LineRest(const char* p, const char* end) {
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned hit = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+        if (hit) return p + __builtin_ctz(hit);
+        p += 16;
+    }
+    return scalarLineRest(p, end);
+}
+
+const char* sse2Identifier(const char* p, const char* end) {
+    for (int i = 0; i < SHORT_RUN && p < end; i++, p++) {
+        if (!isAlphaNumericChar(*p)) return p;
+    }
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(identifierMask16(chunk))) & 0xFFFF;
+        if (stop) return p + __builtin_ctz(stop);
+        p += 16;
+    }
+    return scalarIdentifier(p, end);
+}
+
+const char* sse2StringBody(const char* p, const char* end, int* newlines) {
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned quote = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')));
+        unsigned lines = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+        if (quote) {
+            unsigned at = __builtin_ctz(quote);
+            *newlines += __builtin_popcount(lines & lowBitsBelow(at));
+            return p + at;
+        }
+        *newlines += __builtin_popcount(lines);
+        p += 16;
+    }
+    return scalarStringBody(p, end, newlines);
+}
+
+const ScanKernels SSE2_KERNELS{
+    sse2Whitespace, sse2LineRest, sse2Identifier, sse2StringBody, "sse2"
+};
+
+//==============================================================================
+// AVX2 kernels (32 bytes per step), only used when the CPU reports AVX2
+//==============================================================================
+#define LOX_AVX2 __attribute__((target("avx2")))
+
+LOX_AVX2 inline uint64_t lowBitsBelow64(unsigned bit) {
+    return (uint64_t{1} << bit) - 1;
+}
+
+LOX_AVX2 inline __m256i identifierMask32(__m256i chunk) {
+    __m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+    __m256i alpha = _mm256_and_si256(
+        _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    __m256i digit = _mm256_and_si256(
+        _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk));
+    __m256i underscore = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_'));
+    return _mm256_or_si256(_mm256_or_si256(alpha, digit), underscore);
+}
+
+LOX_AVX2 const char* avx2Whitespace(const char* p, const char* end, int* newlines) {
+    for (int i = 0; i < SHORT_RUN && p < end; i++, p++) {
+        if (*p == '\n') {
+            (*newlines)++;
+        } else if (!(charClass(*p).flags & SPACE)) {
+            return p;
+        }
+    }
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i nl = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'));
+        __m256i space = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')), nl));
+        uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(space));
+        uint32_t lines = static_cast<uint32_t>(_mm256_movemask_epi8(nl));
+        if (stop) {
+            unsigned at = __builtin_ctz(stop);
+            *newlines += __builtin_popcountll(lines & lowBitsBelow64(at));
+            return p + at;
+        }
+        *newlines += __builtin_popcount(lines);
+        p += 32;
+    }
+    return sse2Whitespace(p, end, newlines);
+}
+
+LOX_AVX2 const char* avx2LineRest(const char* p, const char* end) {
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t hit = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+        if (hit) return p + __builtin_ctz(hit);
+        p += 32;
+    }
+    return sse2LineRest(p, end);
+}
+
+LOX_AVX2 const char* avx2Identifier(const char* p, const char* end) {
+    for (int i = 0; i < SHORT_RUN && p < end; i++, p++) {
+        if (!isAlphaNumericChar(*p)) return p;
+    }
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(identifierMask32(chunk)));
+        if (stop) return p + __builtin_ctz(stop);
+        p += 32;
+    }
+    return sse2Identifier(p, end);
+}
+
+LOX_AVX2 const char* avx2StringBody(const char* p, const char* end, int* newlines) {
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t quote = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')));
+        uint32_t lines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+        if (quote) {
+            unsigned at = __builtin_ctz(quote);
+            *newlines += __builtin_popcountll(lines & lowBitsBelow64(at));
+            return p + at;
+        }
+        *newlines += __builtin_popcount(lines);
+        p += 32;
+    }
+    return sse2StringBody(p, end, newlines);
+}
+
+#undef LOX_AVX2
+
+const ScanKernels AVX2_KERNELS{
+    avx2Whitespace, avx2LineRest, avx2Identifier, avx2StringBody, "avx2"
+};
+#endif // LOX_SCAN_X86
+
+const ScanKernels& kernelsFor(KernelSet set) {
+#ifdef LOX_SCAN_X86
+    switch (set)
+    {
+    case KernelSet::AVX2: return AVX2_KERNELS;
+    case KernelSet::SSE2: return SSE2_KERNELS;
+    default: break;
+    }
+#endif
+    return SCALAR_KERNELS;
+}
+
+std::atomic<const ScanKernels*> activeKernels{nullptr};
+
+} // anonymous namespace
+
+//==============================================================================
+// Selection
+//==============================================================================
+bool kernelSetSupported(KernelSet set) {
+    switch (set)
+    {
+    case KernelSet::SCALAR: return true;
+#ifdef LOX_SCAN_X86
+    case KernelSet::SSE2: return true;
+    case KernelSet::AVX2: 
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default: return false;
+    }
+}
+
+KernelSet bestKernelSet() {
+    if (kernelSetSupported(KernelSet::AVX2)) return KernelSet::AVX2;
+    if (kernelSetSupported(KernelSet::SSE2)) return KernelSet::SSE2;
+    return KernelSet::SCALAR;
+}
+
+const ScanKernels& scanKernels() {
+    auto* kernels = activeKernels.load(std::memory_order_relaxed);
+    if (kernels == nullptr) {
+        kernels = &kernelsFor(bestKernelSet());
+        activeKernels.store(kernels, std::memory_order_relaxed);
+    }
+    return *kernels;
+}
+
+void setScanKernels(KernelSet set) {
+    auto* kernels = &kernelsFor(kernelSetSupported(set) ? set : KernelSet::SCALAR);
+    activeKernels.store(kernels, std::memory_order_relaxed);
+}
+
+} // Lox namespace
@@ -1,27 +1,96 @@
 #include "../include/scanner.hpp"
+#include "../include/char_class.hpp"
+
+#include <array>
+#include <cstring>
 
 namespace Lox {
 
-std::unordered_map<std::string, TokenType> Scanner::keywords{
-    {"and",    TokenType::AND},
-    {"class",  TokenType::CLASS},
-    {"else",   TokenType::ELSE},
-    {"false",  TokenType::FALSE},
-    {"for",    TokenType::FOR},
-    {"fun",    TokenType::FUN},
-    {"if",     TokenType::IF},
-    {"nil",    TokenType::NIL},
-    {"or",     TokenType::OR},
-    {"print",  TokenType::PRINT},
-    {"return", TokenType::RETURN},
-    {"super",  TokenType::SUPER},
-    {"this",   TokenType::THIS},
-    {"true",   TokenType::TRUE},
-    {"var",    TokenType::VAR},
-    {"while",  TokenType::WHILE}
+//==============================================================================
+// Keyword lookup
+//==============================================================================
+namespace {
+
+class Keyword {
+public:
+    const char* text;
+    uint32_t length;
+    TokenType type;
+};
+
+constexpr Keyword KEYWORDS[] = {
+    {"and",    3, TokenType::AND},
+    {"class",  5, TokenType::CLASS},
+    {"else",   4, TokenType::ELSE},
+    {"false",  5, TokenType::FALSE},
+    {"for",    3, TokenType::FOR},
+    {"fun",    3, TokenType::FUN},
+    {"if",     2, TokenType::IF},
+    {"nil",    3, TokenType::NIL},
+    {"or",     2, TokenType::OR},
+    {"print",  5, TokenType::PRINT},
+    {"return", 6, TokenType::RETURN},
+    {"super",  5, TokenType::SUPER},
+    {"this",   4, TokenType::THIS},
+    {"true",   4, TokenType::TRUE},
+    {"var",    3, TokenType::VAR},
+    {"while",  5, TokenType::WHILE}
 };
 
-Scanner::Scanner(std::string& source) : _source{source}, _tokens{}
+constexpr uint32_t KEYWORD_TABLE_SIZE = 32;
+
+// Perfect hash over the first two characters and the length. Every keyword is
+// at least two characters long, so shorter words never reach the table.
+constexpr uint32_t keywordHash(const char* text, uint32_t length) {
+    return (static_cast<unsigned char>(text[0]) * 4u 
+          + static_cast<unsigned char>(text[1]) * 3u 
+          + length) & (KEYWORD_TABLE_SIZE - 1);
+}
+
+constexpr std::array<Keyword, KEYWORD_TABLE_SIZE> buildKeywordTable() {
+    std::array<Keyword, KEYWORD_TABLE_SIZE> table{};
+    for (auto& slot : table) slot = Keyword{"", 0, TokenType::IDENTIFIER};
+    for (auto& keyword : KEYWORDS) {
+        table[keywordHash(keyword.text, keyword.length)] = keyword;
+    }
+    return table;
+}
+
+constexpr auto KEYWORD_TABLE = buildKeywordTable();
+
+constexpr bool keywordHashIsPerfect() {
+    for (auto& keyword : KEYWORDS) {
+        if (KEYWORD_TABLE[keywordHash(keyword.text, keyword.length)].type != keyword.type) return false;
+    }
+    return true;
+}
+
+static_assert(keywordHashIsPerfect(), "Keyword hash has collisions");
+
+TokenType keywordType(const char* text, uint32_t length) {
+    if (length < 2) return TokenType::IDENTIFIER;
+    auto& slot = KEYWORD_TABLE[keywordHash(text, length)];
+    if (slot.length == length && std::memcmp(slot.text, text, length) == 0) {
+        return slot.type;
+    }
+    return TokenType::IDENTIFIER;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+// Scanner
+//==============================================================================
+Scanner::Scanner(std::string& source) 
+: Scanner{std::make_shared<const SourceBuffer>(source)}
+{}
+
+Scanner::Scanner(std::shared_ptr<const SourceBuffer> source) 
+: _buffer{std::move(source)}, _source{_buffer->view()}, _tokens{}, _kernels{&scanKernels()}
+{}
+
+Scanner::Scanner(std::string_view source, int line) 
+: _buffer{}, _source{source}, _tokens{}, _kernels{&scanKernels()}, _line{line}
 {}
 
 bool Scanner::isAtEnd() {
@@ -43,36 +112,31 @@ char Scanner::peekNext() {
 
 }
 
-bool Scanner::isDigit(char c) {
-    return c >= '0' && c <= '9';
+void Scanner::addToken(const TokenType& type) {
+    _tokens.push_back(CompactToken{
+        type,
+        static_cast<uint32_t>(_start),
+        static_cast<uint32_t>(_current - _start),
+        _line
+    });
 }
 
-bool Scanner::isAlpha(char c) {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+// Jump to the end of a run found by one of the scan kernels
+void Scanner::skip(const char* to) {
+    _current = static_cast<int>(to - _source.data());
 }
 
-bool Scanner::isAlphaNumeric(char c) {
-    return isAlpha(c) || isDigit(c);
+void Scanner::error(const std::string& message) {
+    _errors.push_back(ScanError{_tokens.size(), _line, message});
 }
 
-void Scanner::addToken(const TokenType& type) {
-    addToken(type, Value{std::monostate{}});
-}
-
-void Scanner::addToken(const TokenType& type, Value literal) {
-    std::string text = _source.substr(_start, _current-_start);
-    _tokens.push_back(
-        Token{type,text,literal,_line}
-    );
+void Scanner::reportErrors() {
+    for (auto& error : _errors) {
+        Lox::error(error.line, error.message);
+    }
+    _errors.clear();
 }
 
-// void Scanner::addToken(const TokenType& type, std::variant<double,bool,std::string,std::monostate,std::shared_ptr<LoxCallable>> literal) {
-//     std::string text = _source.substr(_start, _current-_start);
-//     _tokens.push_back(
-//         Token{type,text,literal,_line}
-//     );
-// }
-
 bool Scanner::match(char expected) {
     if (isAtEnd()) return false;
     if (_source[_current] != expected) return false;
@@ -82,105 +146,131 @@ bool Scanner::match(char expected) {
 }
 
 void Scanner::number() {
-    while(isDigit(peek())) advance();
+    while(isDigitChar(peek())) advance();
 
     // Look for a fractional (decimal) part
-    if (peek() == '.' && isDigit(peekNext())) {
+    if (peek() == '.' && isDigitChar(peekNext())) {
         advance();
 
-        while (isDigit(peek())) advance();
+        while (isDigitChar(peek())) advance();
     }
 
-    addToken(TokenType::NUMBER,Value{std::stod(_source.substr(_start,_current-_start))});
+    // The value is decoded later, by whoever asks for the literal
+    addToken(TokenType::NUMBER);
 
 }
 
 void Scanner::identifier() {
-    while(isAlphaNumeric(peek())) advance();
+    skip(_kernels->identifier(_source.data() + _current, _source.data() + _source.length()));
 
-    std::string text = _source.substr(_start,_current-_start);
-    if (keywords.find(text) != keywords.end())
-    {
-        addToken(keywords.at(text));
-    } else {
-        addToken(TokenType::IDENTIFIER);
-    }
+    addToken(keywordType(_source.data() + _start, _current - _start));
 }
 
 void Scanner::string() {
-    while (peek() != '"' && !isAtEnd()) {
-        if (peek() == '\n') _line++;
-        advance();
-    }
+    skip(_kernels->stringBody(_source.data() + _current, _source.data() + _source.length(), &_line));
 
     if (isAtEnd()) {
-        Lox::error(_line, "Unterminated string.");
+        error("Unterminated string.");
         return;
     }
 
     // Closing part of string
     advance();
 
-    // Remove surrounding quote symbols 
-    std::string value = _source.substr(_start + 1, _current -_start - 2);
-    addToken(TokenType::STRING, Value{value});
+    // The lexeme keeps its quotes; CompactToken::literal strips them
+    addToken(TokenType::STRING);
 }
 
-std::list<Token> Scanner::scanTokens() {
+CompactToken Scanner::next() {
+    while (!isAtEnd()) {
+        // Beginning of next lexeme
+        _start = _current;
+        scanToken();
+        if (!_errors.empty() && !_holdErrors) reportErrors();
+
+        // _tokens never holds more than the one token just scanned
+        if (!_tokens.empty()) {
+            auto token = _tokens.back();
+            _tokens.clear();
+            return token;
+        }
+    }
+
+    return CompactToken{TokenType::END, static_cast<uint32_t>(_current), 0, _line};
+}
+
+std::vector<CompactToken> Scanner::scanCompactTokens() {
+    scanPrefix(true);
+
+    _start = _current;
+    addToken(TokenType::END);
+
+    return std::move(_tokens);
+}
+
+size_t Scanner::scanPrefix(bool final) {
+    // A token is only known to be complete if the scanner could look two
+    // characters past its end (e.g. "12." followed by a digit)
+    size_t limit = final ? _source.length() : (_source.length() < 2 ? 0 : _source.length() - 2);
 
     while (!isAtEnd()) {
         // Beginning of next lexeme
         _start = _current;
+        auto tokenCount = _tokens.size();
+        auto errorCount = _errors.size();
+        int line = _line;
+
         scanToken();
+
+        if (static_cast<size_t>(_current) > limit) {
+            // Leave the partial token for the next window
+            _tokens.resize(tokenCount);
+            _errors.resize(errorCount);
+            _line = line;
+            _current = _start;
+            break;
+        }
+        if (!_errors.empty() && !_holdErrors) reportErrors();
     }
-    Token final_token{TokenType::END, "", Value{std::monostate{}}, _line};
-    _tokens.push_back(final_token);
 
-    return _tokens;
+    return _current;
+}
+
+std::list<Token> Scanner::scanTokens() {
+    std::list<Token> tokens{};
+    for (auto& token : scanCompactTokens()) {
+        tokens.push_back(token.materialize(_source));
+    }
+    return tokens;
 }
 
 void Scanner::scanToken() {
     char c = advance();
-    switch (c)
+    auto& cls = charClass(c);
+    switch (cls.action)
     {
-    case '(': addToken(TokenType::LEFT_PAREN);break;
-    case ')': addToken(TokenType::RIGHT_PAREN); break; 
-    case '{': addToken(TokenType::LEFT_BRACE); break; 
-    case '}': addToken(TokenType::RIGHT_BRACE); break; 
-    case ',': addToken(TokenType::COMMA); break;
-    case '.': addToken(TokenType::DOT); break;
-    case '-': addToken(TokenType::MINUS); break; 
-    case '+': addToken(TokenType::PLUS); break;
-    case ';': addToken(TokenType::SEMICOLON); break; 
-    case '*': addToken(TokenType::STAR); break;
-    case '!': addToken(match('=') ? TokenType::BANG_EQUAL : TokenType::BANG); break;
-    case '=': addToken(match('=') ? TokenType::EQUAL_EQUAL : TokenType::EQUAL); break;
-    case '<': addToken(match('=') ? TokenType::LESS_EQUAL : TokenType::LESS); break;
-    case '>': addToken(match('=') ? TokenType::GREATER_EQUAL : TokenType::GREATER); break;
-    case '/': {
+    case CharAction::SKIP:
+    case CharAction::NEWLINE:
+        // Swallow the whole whitespace run, including this character
+        skip(_kernels->whitespace(_source.data() + _start, _source.data() + _source.length(), &_line));
+        break;
+    case CharAction::SINGLE: addToken(cls.single); break;
+    case CharAction::WITH_EQUAL: addToken(match('=') ? cls.withEqual : cls.single); break;
+    case CharAction::SLASH: {
         if (match('/')) {
-            while(peek() != '\n' && !isAtEnd()) advance();
+            skip(_kernels->lineRest(_source.data() + _current, _source.data() + _source.length()));
         } else {
             addToken(TokenType::SLASH);
         }
         break;
     }
-    case ' ': 
-    case '\r':
-    case '\t':
-        break;
-    case '\n': _line++; break;
-    case '"': string(); break;
-    default:
-        if (isDigit(c)) {
-            number();
-        } else if (isAlpha(c)) {
-            identifier();
-        } else {
-            Lox::error(_line,"Unexpected character.");
-        }
+    case CharAction::STRING: string(); break;
+    case CharAction::NUMBER: number(); break;
+    case CharAction::IDENTIFIER: identifier(); break;
+    case CharAction::INVALID:
+        error("Unexpected character.");
         break;
     }
 }
 
-} // Lox namespace
\ No newline at end of file
+} // Lox namespace
@@ -0,0 +1,56 @@
+#include "../include/source_buffer.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LOX_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Lox {
+
+SourceBuffer::SourceBuffer(std::string text) 
+: _text{std::move(text)}, _data{_text.data()}, _size{_text.size()}
+{}
+
+SourceBuffer::SourceBuffer(const char* mapping, size_t size) 
+: _text{}, _data{mapping}, _size{size}, _mapped{true}
+{}
+
+SourceBuffer::~SourceBuffer() {
+#ifdef LOX_HAVE_MMAP
+    if (_mapped) munmap(const_cast<char*>(_data), _size);
+#endif
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromFile(const std::string& path) {
+#ifdef LOX_HAVE_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t size = static_cast<size_t>(info.st_size);
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping != MAP_FAILED) {
+            // The scanner reads front to back exactly once
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            return std::shared_ptr<const SourceBuffer>{new SourceBuffer{static_cast<const char*>(mapping), size}};
+        }
+    } else {
+        close(fd);
+    }
+#endif
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return nullptr;
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return std::make_shared<const SourceBuffer>(std::move(text));
+}
+
+} // Lox namespace
@@ -0,0 +1,62 @@
+#include "../include/streaming_scanner.hpp"
+#include "../include/scanner.hpp"
+
+namespace Lox {
+
+StreamingScanner::StreamingScanner(std::istream& input, size_t windowSize) 
+: _input{input}, _windowSize{windowSize > 0 ? windowSize : DEFAULT_WINDOW_SIZE}, _window{}, _pending{}, _errors{}, _lexemes{}
+{}
+
+// Append the next window's worth of input after whatever was carried over.
+// Returns true if the input is exhausted.
+bool StreamingScanner::readWindow() {
+    auto carried = _window.size();
+    _window.resize(carried + _windowSize);
+    _input.read(_window.data() + carried, _windowSize);
+    auto count = static_cast<size_t>(_input.gcount());
+    _window.resize(carried + count);
+    return count < _windowSize;
+}
+
+// Drop what the previous window consumed, read the next one and scan its
+// complete tokens
+void StreamingScanner::scanWindow() {
+    _window.erase(0, _consumed);
+    _last = readWindow();
+
+    Scanner scanner{std::string_view{_window}, _line};
+    scanner.holdErrors();
+    _consumed = scanner.scanPrefix(_last);
+    _line = scanner.line();
+
+    _pending = std::move(scanner.tokens());
+    _nextPending = 0;
+    _errors = std::move(scanner.errors());
+    _nextError = 0;
+}
+
+CompactToken StreamingScanner::next() {
+    // Windows can end up without a complete token (e.g. inside a long comment)
+    while (true) {
+        // A window's trailing errors come out before the next one is read
+        while (_nextError < _errors.size() && _errors[_nextError].token <= _nextPending) {
+            Lox::error(_errors[_nextError].line, _errors[_nextError].message);
+            _nextError++;
+        }
+        if (_nextPending < _pending.size()) break;
+        if (_last) {
+            auto slot = _handedOut++ % _lexemes.size();
+            _lexemes[slot].clear();
+            return CompactToken{TokenType::END, static_cast<uint32_t>(slot), 0, _line};
+        }
+        scanWindow();
+    }
+
+    auto token = _pending[_nextPending++];
+    auto slot = _handedOut++ % _lexemes.size();
+    _lexemes[slot].assign(_window, token.offset, token.length);
+    token.offset = static_cast<uint32_t>(slot);
+    return token;
+}
+
+} // Lox namespace
@@ -0,0 +1,108 @@
+#include "../include/string_table.hpp"
+
+#include <cstring>
+
+namespace Lox {
+
+namespace {
+
+// A removed entry; lookups probe past it, inserts may reuse it
+LoxString* const TOMBSTONE = reinterpret_cast<LoxString*>(alignof(LoxString));
+
+constexpr size_t INITIAL_CAPACITY = 256;
+
+} // anonymous namespace
+
+// Never destroyed, since interned strings held by other statics are freed
+// after anything here would be
+StringTable& StringTable::table() {
+    static auto* table = new StringTable{};
+    return *table;
+}
+
+//==============================================================================
+// Interning
+//==============================================================================
+LoxString* StringTable::intern(std::string_view chars) {
+    auto& table = StringTable::table();
+    uint32_t hash = LoxString::hashOf(chars);
+    if (!table._entries.empty()) {
+        LoxString* string = table._entries[table.find(chars, hash)].string;
+        if (string != nullptr) return string;
+    }
+    LoxString* string = LoxString::make(chars);
+    string->_hash = hash;
+    string->_hashed = true;
+    table.insert(string);
+    return string;
+}
+
+LoxString* StringTable::intern(LoxString* string) {
+    auto& table = StringTable::table();
+    if (!table._entries.empty()) {
+        LoxString* entry = table._entries[table.find(string->view(), string->hash())].string;
+        if (entry != nullptr) return entry;
+    }
+    table.insert(string);
+    return string;
+}
+
+void StringTable::remove(LoxString* string) {
+    auto& table = StringTable::table();
+    size_t mask = table._entries.size() - 1;
+    for (size_t i = string->hash() & mask; ; i = (i + 1) & mask) {
+        if (table._entries[i].string == string) {
+            table._entries[i].string = TOMBSTONE;
+            table._count--;
+            table._tombstones++;
+            return;
+        }
+    }
+}
+
+//==============================================================================
+// Probing
+//==============================================================================
+size_t StringTable::find(std::string_view chars, uint32_t hash) const {
+    size_t mask = _entries.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const Entry& entry = _entries[i];
+        if (entry.string == nullptr) return i;
+        if (entry.hash == hash && entry.string != TOMBSTONE && entry.string->view() == chars) {
+            return i;
+        }
+    }
+}
+
+// Kept at most half full, tombstones included, so probes stay short
+void StringTable::insert(LoxString* string) {
+    if ((_count + _tombstones + 1) * 2 > _entries.size()) grow();
+
+    size_t mask = _entries.size() - 1;
+    size_t i = string->hash() & mask;
+    while (_entries[i].string != nullptr && _entries[i].string != TOMBSTONE) i = (i + 1) & mask;
+    if (_entries[i].string == TOMBSTONE) _tombstones--;
+    _entries[i] = Entry{string, string->hash()};
+    _count++;
+    string->_interned = string;
+}
+
+// Doubles only if the live entries need it; otherwise this just clears
+// out the tombstones
+void StringTable::grow() {
+    size_t capacity = _entries.empty() ? INITIAL_CAPACITY : _entries.size();
+    if ((_count + 1) * 4 > capacity) capacity *= 2;
+
+    std::vector<Entry> entries(capacity, Entry{nullptr, 0});
+    size_t mask = capacity - 1;
+    for (const Entry& entry : _entries) {
+        if (entry.string == nullptr || entry.string == TOMBSTONE) continue;
+        size_t i = entry.hash & mask;
+        while (entries[i].string != nullptr) i = (i + 1) & mask;
+        entries[i] = entry;
+    }
+    _entries.swap(entries);
+    _tombstones = 0;
+}
+
+} // Lox namespace
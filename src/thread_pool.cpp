@@ -0,0 +1,56 @@
+#include "../include/thread_pool.hpp"
+
+namespace Lox {
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = 1;
+    for (unsigned i = 0; i < threads; i++) {
+        _workers.emplace_back([this]() { work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _stopping = true;
+    }
+    _available.notify_all();
+    for (auto& worker : _workers) worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _tasks.push(std::move(task));
+    }
+    _available.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock{_mutex};
+    _finished.wait(lock, [this]() { return _tasks.empty() && _running == 0; });
+}
+
+void ThreadPool::work() {
+    for (;;) {
+        std::function<void()> task{};
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _available.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+            if (_tasks.empty()) return;
+            task = std::move(_tasks.front());
+            _tasks.pop();
+            _running++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _running--;
+        }
+        _finished.notify_all();
+    }
+}
+
+} // Lox namespace
@@ -0,0 +1,493 @@
+#include "../include/transpiler.hpp"
+#include "../include/global_table.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace Lox {
+
+std::string Transpiler::transpile(Program& program, const std::string& source) {
+    _code.clear();
+    _indent = 1;
+    _inFunction = false;
+    _stackUsed.assign(program.frameSize, false);
+    _cellsUsed.assign(program.cells, false);
+    for (auto* statement : program.statements) {
+        statement->accept(this);
+    }
+    // The top level runs in a frame of its own, like a call without arguments
+    std::string script = "void script() {\n" + frame(program.frameSize, program.cells, nullptr) + _code + "}\n";
+
+    std::string out = "// Generated by loxc from " + source + "\n";
+    out += "#include \"aot_runtime.hpp\"\n\nnamespace {\n\n";
+    if (!_constants.empty()) out += "Lox::Value* k;\n";
+    for (size_t i = 0; i < _globals.size(); i++) {
+        out += "Lox::Global* " + global(_globals[i]) + ";\n";
+    }
+    out += "\n";
+    for (auto& prototype : _prototypes) {
+        out += prototype + ";\n";
+    }
+    out += "\n";
+    for (auto& definition : _definitions) {
+        out += definition + "\n";
+    }
+    out += script;
+    out += "\n} // anonymous namespace\n\nint main() {\n";
+
+    // Interned strings and globals only exist once main runs
+    if (!_constants.empty()) {
+        out += "    k = new Lox::Value[" + std::to_string(_constants.size()) + "]{\n";
+        for (auto& text : _constants) {
+            out += "        Lox::Value{std::string_view{" + quote(text) + ", " + std::to_string(text.size()) + "}},\n";
+        }
+        out += "    };\n";
+    }
+    for (auto* g : _globals) {
+        out += "    " + global(g) + " = Lox::Aot::global(" + quote(g->name.asString()) + ");\n";
+    }
+    out += "    return Lox::Aot::run(script);\n}\n";
+    return out;
+}
+
+//==============================================================================
+// Expr visitor implementation
+//==============================================================================
+void Transpiler::visitBinaryExpr(Binary* b) {
+    std::string left = evaluate(b->left);
+    if (!_stable && mayAssign(b->right)) left = temp(left);
+    bool leftStable = _stable || mayAssign(b->right);
+    std::string right = evaluate(b->right);
+
+    switch (b->op) {
+    case TokenType::PLUS: _result = operation("add", b->line, left, right); break;
+    case TokenType::MINUS: _result = operation("subtract", b->line, left, right); break;
+    case TokenType::STAR: _result = operation("multiply", b->line, left, right); break;
+    case TokenType::SLASH: _result = operation("divide", b->line, left, right); break;
+    case TokenType::GREATER: _result = operation("greater", b->line, left, right); break;
+    case TokenType::GREATER_EQUAL: _result = operation("greaterEqual", b->line, left, right); break;
+    case TokenType::LESS: _result = operation("less", b->line, left, right); break;
+    case TokenType::LESS_EQUAL: _result = operation("lessEqual", b->line, left, right); break;
+    case TokenType::EQUAL_EQUAL:
+        // Cannot fail, so it waits for where the value is used
+        _result = "Lox::Value{" + left + " == " + right + "}";
+        _stable = _stable && leftStable;
+        return;
+    case TokenType::BANG_EQUAL:
+        _result = "Lox::Value{" + left + " != " + right + "}";
+        _stable = _stable && leftStable;
+        return;
+    default:
+        _result = "Lox::Value{}";
+        break;
+    }
+    _stable = true;
+}
+
+void Transpiler::visitGroupingExpr(Grouping* g) {
+    g->expression->accept(this);
+}
+
+void Transpiler::visitUnaryExpr(Unary* u) {
+    std::string right = evaluate(u->expression);
+    if (u->op == TokenType::BANG) {
+        _result = "Lox::Value{!Lox::Aot::isTruthy(" + right + ")}";
+        return;
+    }
+    _result = temp("Lox::Aot::negate(" + std::to_string(u->line) + ", " + right + ")");
+    _stable = true;
+}
+
+void Transpiler::visitLiteralExpr(Literal* l) {
+    _result = l->value.isString() ? constant(l->value.asString()) : literal(l->value);
+    _stable = true;
+}
+
+void Transpiler::visitVariableExpr(Variable* v) {
+    _stable = false;
+    switch (v->storage) {
+    case Storage::STACK:
+        _result = stackSlot(v->slot);
+        return;
+    case Storage::CELL:
+        _result = cellSlot(v->slot) + "->value";
+        return;
+    case Storage::UPVALUE:
+        _result = "self->upvalues[" + std::to_string(v->slot) + "]->value";
+        return;
+    case Storage::GLOBAL:
+        break;
+    }
+    _result = temp("Lox::Aot::get(" + std::to_string(v->name.line) + ", " + global(v->global) + ")");
+    _stable = true;
+}
+
+void Transpiler::visitAssignExpr(Assign* a) {
+    std::string value = evaluate(a->value);
+
+    std::string target;
+    switch (a->storage) {
+    case Storage::STACK:
+        target = stackSlot(a->slot);
+        break;
+    case Storage::CELL:
+        target = cellSlot(a->slot) + "->value";
+        break;
+    case Storage::UPVALUE:
+        target = "self->upvalues[" + std::to_string(a->slot) + "]->value";
+        break;
+    case Storage::GLOBAL:
+        emit("Lox::Aot::set(" + std::to_string(a->name.line) + ", " + global(a->global) + ", " + value + ");");
+        _result = value;
+        return;
+    }
+    emit(target + " = " + value + ";");
+    _result = target;
+    _stable = false;
+}
+
+void Transpiler::visitLogicalExpr(Logical* l) {
+    std::string result = temp(evaluate(l->left));
+
+    // OR short-circuit
+    if (l->op == TokenType::OR) {
+        emit("if (!Lox::Aot::isTruthy(" + result + ")) {");
+    } else {
+        emit("if (Lox::Aot::isTruthy(" + result + ")) {");
+    }
+    _indent++;
+    emit(result + " = " + evaluate(l->right) + ";");
+    _indent--;
+    emit("}");
+
+    _result = result;
+    _stable = true;
+}
+
+// The callee and every argument are evaluated in order, as the Interpreter
+// does, so any of them a later one could assign is copied first
+void Transpiler::visitCallExpr(Call* c) {
+    size_t argc = c->arguments.size();
+    // assigns[i]: an argument from the i-th on may assign
+    std::vector<bool> assigns(argc + 1, false);
+    for (size_t i = argc; i-- > 0;) {
+        assigns[i] = assigns[i + 1] || mayAssign(c->arguments[i]);
+    }
+
+    std::string callee = evaluate(c->callee);
+    callee = hold(callee, _stable || !assigns[0]);
+    std::vector<std::string> args{};
+    for (size_t i = 0; i < argc; i++) {
+        std::string argument = evaluate(c->arguments[i]);
+        args.push_back(hold(argument, _stable || !assigns[i + 1]));
+    }
+
+    std::string line = std::to_string(c->line);
+    if (argc == 0) {
+        _result = temp("Lox::Aot::call(" + line + ", " + callee + ", nullptr, 0)");
+    } else {
+        std::string array = "a" + std::to_string(_temps++);
+        std::string values;
+        for (auto& argument : args) {
+            values += (values.empty() ? "" : ", ") + argument;
+        }
+        emit("const Lox::Value " + array + "[] = {" + values + "};");
+        _result = temp("Lox::Aot::call(" + line + ", " + callee + ", " + array + ", " + std::to_string(argc) + ")");
+    }
+    _stable = true;
+}
+
+//==============================================================================
+// Stmt visitor implementation
+//==============================================================================
+void Transpiler::visitExpressionStmt(Expression* stmt) {
+    evaluate(stmt->expr);
+}
+
+void Transpiler::visitFunctionStmt(Function* stmt) {
+    std::string name = function(stmt);
+
+    std::string captures;
+    for (auto& capture : stmt->upvalues) {
+        if (!captures.empty()) captures += ", ";
+        captures += capture.local ? cellSlot(capture.index) : "self->upvalues[" + std::to_string(capture.index) + "]";
+    }
+    std::string value = "Lox::Value{new Lox::AotFunction{&" + name + ", " + std::to_string(stmt->params.size()) +
+        ", Lox::Upvalues{" + captures + "}}}";
+
+    // A local function can call itself, so its own cell has to exist before
+    // the closure captures it
+    if (stmt->storage == Storage::CELL) {
+        std::string cell = cellSlot(stmt->slot);
+        emit(cell + " = std::make_shared<Lox::Cell>();");
+        emit(cell + "->value = " + value + ";");
+        return;
+    }
+    define(stmt->storage, stmt->slot, stmt->global, value);
+}
+
+void Transpiler::visitReturnStmt(Return* stmt) {
+    if (!_inFunction) {
+        emit("return;");
+        return;
+    }
+    std::string value = stmt->value != nullptr ? evaluate(stmt->value) : "Lox::Value{}";
+    emit("return " + value + ";");
+}
+
+void Transpiler::visitVarStmt(Var* stmt) {
+    std::string value = stmt->initializer != nullptr ? evaluate(stmt->initializer) : "Lox::Value{}";
+    define(stmt->storage, stmt->slot, stmt->global, value);
+}
+
+void Transpiler::visitPrintStmt(Print* stmt) {
+    emit("Lox::Aot::print(" + evaluate(stmt->value) + ");");
+}
+
+// A block's locals have their slots in the enclosing frame already, the
+// braces only end its temporaries
+void Transpiler::visitBlockStmt(Block* stmt) {
+    emit("{");
+    emitBody(stmt->statements);
+    emit("}");
+}
+
+void Transpiler::visitIfStmt(If* stmt) {
+    emit("if (Lox::Aot::isTruthy(" + evaluate(stmt->condition) + ")) {");
+    emitBranch(stmt->thenBranch);
+    if (stmt->elseBranch != nullptr) {
+        emit("} else {");
+        emitBranch(stmt->elseBranch);
+    }
+    emit("}");
+}
+
+// A condition that needs statements of its own is evaluated inside the loop
+void Transpiler::visitWhileStmt(While* stmt) {
+    size_t start = _code.size();
+    _indent++;
+    std::string condition = evaluate(stmt->expr);
+    _indent--;
+    std::string conditionCode = _code.substr(start);
+    _code.resize(start);
+
+    if (conditionCode.empty()) {
+        emit("while (Lox::Aot::isTruthy(" + condition + ")) {");
+    } else {
+        emit("for (;;) {");
+        _code += conditionCode;
+        _indent++;
+        emit("if (!Lox::Aot::isTruthy(" + condition + ")) break;");
+        _indent--;
+    }
+    emitBranch(stmt->body);
+    emit("}");
+}
+
+//==============================================================================
+// Utility methods
+//==============================================================================
+std::string Transpiler::evaluate(Expr* expr) {
+    expr->accept(this);
+    return _result;
+}
+
+std::string Transpiler::hold(const std::string& code, bool stable) {
+    return stable ? code : temp(code);
+}
+
+std::string Transpiler::temp(const std::string& code) {
+    std::string name = "t" + std::to_string(_temps++);
+    emit("Lox::Value " + name + " = " + code + ";");
+    return name;
+}
+
+void Transpiler::emit(const std::string& line) {
+    _code.append(4 * _indent, ' ');
+    _code += line;
+    _code += '\n';
+}
+
+// The statements of a branch or loop body, inside braces already emitted
+void Transpiler::emitBranch(Stmt* stmt) {
+    if (stmt->kind == StmtKind::BLOCK) {
+        emitBody(static_cast<Block*>(stmt)->statements);
+        return;
+    }
+    _indent++;
+    stmt->accept(this);
+    _indent--;
+}
+
+void Transpiler::emitBody(const ArenaArray<Stmt*>& statements) {
+    _indent++;
+    for (auto* statement : statements) {
+        statement->accept(this);
+    }
+    _indent--;
+}
+
+// A declaration's first value
+void Transpiler::define(Storage storage, int slot, Global* g, const std::string& value) {
+    switch (storage) {
+    case Storage::STACK:
+        emit(stackSlot(slot) + " = " + value + ";");
+        break;
+    case Storage::CELL:
+        emit(cellSlot(slot) + " = std::make_shared<Lox::Cell>(Lox::Cell{" + value + "});");
+        break;
+    case Storage::UPVALUE:
+        break;
+    case Storage::GLOBAL:
+        emit("Lox::Aot::define(" + global(g) + ", " + value + ");");
+        break;
+    }
+}
+
+// Writes the C++ function for a Lox function's body and returns its name
+std::string Transpiler::function(Function* function) {
+    std::string name = "lox" + std::to_string(_prototypes.size()) + "_" + std::string{function->name.text()};
+    std::string signature = "Lox::Value " + name +
+        "([[maybe_unused]] Lox::AotFunction* self, [[maybe_unused]] const Lox::Value* args)";
+    _prototypes.push_back(signature);
+
+    auto enclosingCode = std::move(_code);
+    auto enclosingIndent = _indent;
+    auto enclosingInFunction = _inFunction;
+    auto enclosingStackUsed = std::move(_stackUsed);
+    auto enclosingCellsUsed = std::move(_cellsUsed);
+
+    _code.clear();
+    _indent = 1;
+    _inFunction = true;
+    _stackUsed.assign(function->frameSize, false);
+    _cellsUsed.assign(function->cells, false);
+    for (auto* statement : function->body) {
+        statement->accept(this);
+    }
+    // Falling off the end returns nil
+    emit("return Lox::Value{};");
+    _definitions.push_back(signature + " {\n" + frame(function->frameSize, function->cells, &function->params) +
+        _code + "}\n");
+
+    _code = std::move(enclosingCode);
+    _indent = enclosingIndent;
+    _inFunction = enclosingInFunction;
+    _stackUsed = std::move(enclosingStackUsed);
+    _cellsUsed = std::move(enclosingCellsUsed);
+    return name;
+}
+
+// Declarations of the slots the body used. Arguments become the first
+// ones; captured parameters move into cells of their own.
+std::string Transpiler::frame(int frameSize, int cells, const ArenaArray<Parameter>* params) {
+    std::vector<bool> declared(frameSize, false);
+    std::string code;
+    if (params != nullptr) {
+        for (size_t i = 0; i < params->size(); i++) {
+            auto& param = (*params)[i];
+            std::string arg = "args[" + std::to_string(i) + "]";
+            if (param.storage == Storage::CELL) {
+                code += "    auto c" + std::to_string(param.slot) + " = std::make_shared<Lox::Cell>(Lox::Cell{" + arg + "});\n";
+            } else {
+                code += "    Lox::Value s" + std::to_string(param.slot) + " = " + arg + ";\n";
+            }
+            declared[param.slot] = true;
+        }
+    }
+    for (int slot = 0; slot < frameSize; slot++) {
+        if (_stackUsed[slot] && !declared[slot]) code += "    Lox::Value s" + std::to_string(slot) + ";\n";
+    }
+    for (int slot = 0; slot < cells; slot++) {
+        if (_cellsUsed[slot] && !declared[slot]) code += "    std::shared_ptr<Lox::Cell> c" + std::to_string(slot) + ";\n";
+    }
+    return code;
+}
+
+std::string Transpiler::stackSlot(int slot) {
+    _stackUsed[slot] = true;
+    return "s" + std::to_string(slot);
+}
+
+std::string Transpiler::cellSlot(int slot) {
+    _cellsUsed[slot] = true;
+    return "c" + std::to_string(slot);
+}
+
+std::string Transpiler::global(Global* g) {
+    auto id = _globalIds.find(g);
+    if (id == _globalIds.end()) {
+        id = _globalIds.emplace(g, _globals.size()).first;
+        _globals.push_back(g);
+    }
+    return "g" + std::to_string(id->second) + "_" + std::string{g->name.asString()};
+}
+
+std::string Transpiler::constant(std::string_view text) {
+    auto id = _constantIds.find(std::string{text});
+    if (id == _constantIds.end()) {
+        id = _constantIds.emplace(std::string{text}, _constants.size()).first;
+        _constants.emplace_back(text);
+    }
+    return "k[" + std::to_string(id->second) + "]";
+}
+
+std::string Transpiler::operation(const char* helper, int line, const std::string& left, const std::string& right) {
+    return temp(std::string{"Lox::Aot::"} + helper + "(" + std::to_string(line) + ", " + left + ", " + right + ")");
+}
+
+// Whether evaluating `expr` could change a variable
+bool Transpiler::mayAssign(Expr* expr) {
+    switch (expr->kind) {
+    case ExprKind::ASSIGN:
+    case ExprKind::CALL:
+        return true;
+    case ExprKind::BINARY: {
+        auto* binary = static_cast<Binary*>(expr);
+        return mayAssign(binary->left) || mayAssign(binary->right);
+    }
+    case ExprKind::LOGICAL: {
+        auto* logical = static_cast<Logical*>(expr);
+        return mayAssign(logical->left) || mayAssign(logical->right);
+    }
+    case ExprKind::GROUPING:
+        return mayAssign(static_cast<Grouping*>(expr)->expression);
+    case ExprKind::UNARY:
+        return mayAssign(static_cast<Unary*>(expr)->expression);
+    default:
+        return false;
+    }
+}
+
+// Numbers keep their exact bits, as hexadecimal floating point
+std::string Transpiler::literal(const Value& value) {
+    if (value.isNil()) return "Lox::Value{}";
+    if (value.isBool()) return value.asBool() ? "Lox::Value{true}" : "Lox::Value{false}";
+    if (value.isInt()) return "Lox::Value{int32_t{" + std::to_string(value.asInt()) + "}}";
+    double number = value.asNumber();
+    if (std::isinf(number)) return number > 0 ? "Lox::Value{HUGE_VAL}" : "Lox::Value{-HUGE_VAL}";
+    char digits[64];
+    std::snprintf(digits, sizeof digits, "%a", number);
+    return std::string{"Lox::Value{"} + digits + "}";
+}
+
+// A C++ string literal. Octal escapes always take three digits, so the next
+// character cannot run into one.
+std::string Transpiler::quote(std::string_view text) {
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c >= 0x20 && c < 0x7f && c != '?') {
+            out += static_cast<char>(c);
+        } else {
+            char escape[5];
+            std::snprintf(escape, sizeof escape, "\\%03o", c);
+            out += escape;
+        }
+    }
+    return out + "\"";
+}
+
+} // Lox namespace
@@ -1,110 +1,51 @@
 #include "../include/value.hpp"
+#include "../include/lox_callable.hpp"
 
 namespace Lox {
 
-Value::Value() {
-    this->item = std::monostate{};
-}
-
-Value::Value(const double& v) {
-    this->item = v;
-}
-
-Value::Value(const bool& v) {
-    this->item = v;
-}
-
-Value::Value(const std::string& v) {
-    this->item = v;
-}
-
-Value::Value(const std::monostate& v) {
-    this->item = v;
-}
-
-Value::Value(std::shared_ptr<LoxCallable>& v) {
-    this->item = v;
-}
+Value::Value(LoxCallable* v) : Value{static_cast<Object*>(v), CALLABLE}
+{}
 
-Value::Value(const std::variant<double,bool,std::string,std::monostate, std::shared_ptr<LoxCallable>>& v) {
-    this->item = v;
+LoxCallable* Value::asCallable() const {
+    return static_cast<LoxCallable*>(object());
 }
 
-// Arithmetic operations
-Value Value::operator+(const Value& rhs) const {
-    if (std::holds_alternative<double>(this->item) && std::holds_alternative<double>(rhs.item)) {
-        return Value{std::get<double>(this->item) + std::get<double>(rhs.item)};
-    }
-    if (std::holds_alternative<std::string>(this->item) && std::holds_alternative<std::string>(rhs.item)) {
-        return Value{std::get<std::string>(this->item) + std::get<std::string>(rhs.item)};
+// The last Value referring to the object is gone
+void Value::destroy() {
+    switch (_bits & 7) {
+    case STRING:
+        LoxString::free(static_cast<LoxString*>(object()));
+        break;
+    case CALLABLE:
+        delete static_cast<LoxCallable*>(object());
+        break;
     }
-    return Value{std::monostate{}};
 }
 
-Value Value::operator-(const Value& rhs) const {
-    if (std::holds_alternative<double>(this->item) && std::holds_alternative<double>(rhs.item)) {
-        return Value{std::get<double>(this->item) - std::get<double>(rhs.item)};
-    }
-    return Value{std::monostate{}};
+// The doubles give the results integers cannot hold exactly as they always
+// have
+Value Value::add(const Value& rhs) const {
+    if (isNumber() && rhs.isNumber()) return Value{asNumber() + rhs.asNumber()};
+    return concatenate(rhs);
 }
 
-Value Value::operator*(const Value& rhs) const {
-    if (std::holds_alternative<double>(this->item) && std::holds_alternative<double>(rhs.item)) {
-        return Value{std::get<double>(this->item) * std::get<double>(rhs.item)};
-    }
-    return Value{std::monostate{}};
+Value Value::subtract(const Value& rhs) const {
+    if (isNumber() && rhs.isNumber()) return Value{asNumber() - rhs.asNumber()};
+    return Value{};
 }
 
-Value Value::operator/(const Value& rhs) const {
-    if (std::holds_alternative<double>(this->item) && std::holds_alternative<double>(rhs.item)) {
-        return Value{std::get<double>(this->item) / std::get<double>(rhs.item)};
-    }
-    return Value{std::monostate{}};
+Value Value::multiply(const Value& rhs) const {
+    if (isNumber() && rhs.isNumber()) return Value{asNumber() * rhs.asNumber()};
+    return Value{};
 }
 
-// Relational operators
-bool Value::operator>(const Value& rhs) const {
-    if (std::holds_alternative<double>(this->item) && std::holds_alternative<double>(rhs.item)) {
-        return std::get<double>(this->item) > std::get<double>(rhs.item);
+// What + does to anything but two numbers
+Value Value::concatenate(const Value& rhs) const {
+    if (isString() && rhs.isString()) {
+        return Value{LoxString::concatenate(static_cast<LoxString*>(object()),
+            static_cast<LoxString*>(rhs.object()))};
     }
-    return false;
+    return Value{};
 }
 
-bool Value::operator>=(const Value& rhs) const {
-    if (std::holds_alternative<double>(this->item) && std::holds_alternative<double>(rhs.item)) {
-        return std::get<double>(this->item) >= std::get<double>(rhs.item);
-    }
-    return false;
-}
-
-bool Value::operator<(const Value& rhs) const {
-    return rhs > (*this);
-}
-
-bool Value::operator<=(const Value& rhs) const {
-    return rhs >= (*this);
-}
-
-bool Value::operator==(const Value& rhs) const {
-    if (std::holds_alternative<bool>(this->item) && std::holds_alternative<bool>(rhs.item)) {
-        return std::get<bool>(this->item) == std::get<bool>(rhs.item);
-    }
-    if (std::holds_alternative<double>(this->item) && std::holds_alternative<double>(rhs.item)) {
-        return std::get<double>(this->item) == std::get<double>(rhs.item);
-    }
-    if (std::holds_alternative<std::string>(this->item) && std::holds_alternative<std::string>(rhs.item)) {
-        return std::get<std::string>(this->item) == std::get<std::string>(rhs.item);
-    }
-    if (std::holds_alternative<std::monostate>(this->item) && std::holds_alternative<std::monostate>(rhs.item)) {
-        return true;
-    }
-    
-    return false;
-}
-
-bool Value::operator!=(const Value& rhs) const {
-    return !((*this) == rhs);
-}
-
-
-} // Lox namespace
\ No newline at end of file
+} // Lox namespace
@@ -0,0 +1,387 @@
+#include "../include/vm.hpp"
+#include "../include/compiler.hpp"
+#include "../include/lox.hpp"
+
+// Threaded dispatch, one indirect jump per instruction, where GCC's labels
+// as values are available; a switch everywhere else
+#if defined(__GNUC__)
+#define LOX_COMPUTED_GOTO
+#endif
+
+namespace Lox {
+
+namespace {
+
+uint16_t read16(const uint8_t*& ip) {
+    uint16_t operand;
+    std::memcpy(&operand, ip, sizeof operand);
+    ip += sizeof operand;
+    return operand;
+}
+
+uint32_t read32(const uint8_t*& ip) {
+    uint32_t operand;
+    std::memcpy(&operand, ip, sizeof operand);
+    ip += sizeof operand;
+    return operand;
+}
+
+bool isFalsey(const Value& v) {
+    return v.isNil() || (v.isBool() && !v.asBool());
+}
+
+} // anonymous namespace
+
+VM::VM(Interpreter* interpreter)
+: _interpreter{interpreter}, _stack{}, _frames{}, _frameCount{0}, _cells{}, _top{nullptr}
+{}
+
+void VM::interpret(Program& program) {
+    if (_stack == nullptr) {
+        _stack = std::make_unique<Value[]>(STACK_SIZE);
+        // Left uninitialized, a frame is written whole when a call starts
+        _frames.reset(new CallFrame[MAX_FRAMES]);
+    }
+
+    Compiler compiler{};
+    Chunk* chunk = compiler.compile(program);
+    if (Lox::hadError) return;
+
+    _top = _stack.get();
+    try {
+        if (static_cast<size_t>(chunk->frameSize + chunk->maxStack) > STACK_SIZE) {
+            throw RuntimeError{0, "Stack overflow."};
+        }
+        _cells.resize(chunk->cells);
+        _frames[0] = CallFrame{nullptr, chunk, _stack.get(), 0, nullptr};
+        _frameCount = 1;
+        run();
+    } catch (RuntimeError& error) {
+        Lox::runtimeError(error);
+        // An error can leave any number of calls' frames behind
+        for (Value* v = _stack.get(); v != _top; v++) *v = Value{};
+        _cells.clear();
+        _frameCount = 0;
+    }
+}
+
+// Everything at and above `sp` is nil: popping moves values out, and a
+// returning call clears its frame
+void VM::run() {
+    CallFrame* frame = &_frames[_frameCount - 1];
+    Chunk* chunk = frame->chunk;
+    const uint8_t* ip = chunk->code.data();
+    Value* slots = frame->slots;
+    Value* sp = slots + chunk->frameSize;
+    Value* const stackEnd = _stack.get() + STACK_SIZE;
+
+#define VM_ERROR(message) \
+    do { \
+        _top = sp; \
+        throw RuntimeError{chunk->line(ip - 1 - chunk->code.data()), message}; \
+    } while (false)
+
+#ifdef LOX_COMPUTED_GOTO
+    // In OpCode order
+    static void* labels[] = {
+        &&op_CONSTANT, &&op_NIL, &&op_TRUE, &&op_FALSE, &&op_POP,
+        &&op_GET_LOCAL, &&op_SET_LOCAL, &&op_STORE_LOCAL,
+        &&op_GET_CELL, &&op_SET_CELL, &&op_DEFINE_CELL, &&op_NEW_CELL,
+        &&op_GET_UPVALUE, &&op_SET_UPVALUE,
+        &&op_GET_GLOBAL, &&op_SET_GLOBAL, &&op_DEFINE_GLOBAL,
+        &&op_EQUAL, &&op_NOT_EQUAL, &&op_GREATER, &&op_GREATER_EQUAL, &&op_LESS, &&op_LESS_EQUAL,
+        &&op_ADD, &&op_SUBTRACT, &&op_MULTIPLY, &&op_DIVIDE, &&op_NOT, &&op_NEGATE,
+        &&op_PRINT,
+        &&op_JUMP, &&op_JUMP_IF_FALSE, &&op_JUMP_IF_TRUE, &&op_POP_JUMP_IF_FALSE, &&op_LOOP,
+        &&op_CALL, &&op_CLOSURE, &&op_RETURN
+    };
+    static_assert(sizeof labels / sizeof labels[0] == static_cast<size_t>(OpCode::RETURN) + 1,
+        "every instruction needs a label");
+#define VM_CASE(name) op_##name
+#define VM_NEXT() goto *labels[*ip++]
+    VM_NEXT();
+#else
+#define VM_CASE(name) case OpCode::name
+#define VM_NEXT() continue
+    for (;;) switch (static_cast<OpCode>(*ip++))
+#endif
+    {
+    VM_CASE(CONSTANT): {
+        *sp++ = chunk->constants[read32(ip)];
+        VM_NEXT();
+    }
+    VM_CASE(NIL): {
+        *sp++ = Value{};
+        VM_NEXT();
+    }
+    VM_CASE(TRUE): {
+        *sp++ = Value{true};
+        VM_NEXT();
+    }
+    VM_CASE(FALSE): {
+        *sp++ = Value{false};
+        VM_NEXT();
+    }
+    VM_CASE(POP): {
+        *--sp = Value{};
+        VM_NEXT();
+    }
+
+    VM_CASE(GET_LOCAL): {
+        *sp++ = slots[read16(ip)];
+        VM_NEXT();
+    }
+    VM_CASE(SET_LOCAL): {
+        slots[read16(ip)] = sp[-1];
+        VM_NEXT();
+    }
+    VM_CASE(STORE_LOCAL): {
+        slots[read16(ip)] = std::move(*--sp);
+        VM_NEXT();
+    }
+    VM_CASE(GET_CELL): {
+        *sp++ = _cells[frame->cellBase + read16(ip)]->value;
+        VM_NEXT();
+    }
+    VM_CASE(SET_CELL): {
+        _cells[frame->cellBase + read16(ip)]->value = sp[-1];
+        VM_NEXT();
+    }
+    VM_CASE(DEFINE_CELL): {
+        _cells[frame->cellBase + read16(ip)] = std::make_shared<Cell>(Cell{std::move(*--sp)});
+        VM_NEXT();
+    }
+    VM_CASE(NEW_CELL): {
+        _cells[frame->cellBase + read16(ip)] = std::make_shared<Cell>();
+        VM_NEXT();
+    }
+    VM_CASE(GET_UPVALUE): {
+        *sp++ = (*frame->upvalues)[read16(ip)]->value;
+        VM_NEXT();
+    }
+    VM_CASE(SET_UPVALUE): {
+        (*frame->upvalues)[read16(ip)]->value = sp[-1];
+        VM_NEXT();
+    }
+    VM_CASE(GET_GLOBAL): {
+        Global* global = chunk->globals[read32(ip)];
+        if (!global->defined) {
+            VM_ERROR("Undefined variable '" + std::string{global->name.asString()} + "'.");
+        }
+        *sp++ = global->value;
+        VM_NEXT();
+    }
+    VM_CASE(SET_GLOBAL): {
+        Global* global = chunk->globals[read32(ip)];
+        if (!global->defined) {
+            VM_ERROR("Undefined variable " + std::string{global->name.asString()} + ".");
+        }
+        global->value = sp[-1];
+        VM_NEXT();
+    }
+    VM_CASE(DEFINE_GLOBAL): {
+        Global* global = chunk->globals[read32(ip)];
+        global->value = std::move(*--sp);
+        global->defined = true;
+        VM_NEXT();
+    }
+
+    // Arithmetic only makes nil out of operands of the wrong type, and two
+    // integers compare without a check, as in the tree-walker
+#define VM_ARITHMETIC(op, message) \
+    { \
+        Value result = sp[-2] op sp[-1]; \
+        if (result.isNil()) VM_ERROR(message); \
+        *--sp = Value{}; \
+        sp[-1] = std::move(result); \
+        VM_NEXT(); \
+    }
+#define VM_COMPARISON(op) \
+    { \
+        const Value& left = sp[-2]; \
+        const Value& right = sp[-1]; \
+        if ((!left.isInt() || !right.isInt()) && (!left.isNumber() || !right.isNumber())) { \
+            VM_ERROR("Operands must be double."); \
+        } \
+        bool result = left op right; \
+        *--sp = Value{}; \
+        sp[-1] = Value{result}; \
+        VM_NEXT(); \
+    }
+
+    VM_CASE(EQUAL): {
+        bool result = sp[-2] == sp[-1];
+        *--sp = Value{};
+        sp[-1] = Value{result};
+        VM_NEXT();
+    }
+    VM_CASE(NOT_EQUAL): {
+        bool result = sp[-2] != sp[-1];
+        *--sp = Value{};
+        sp[-1] = Value{result};
+        VM_NEXT();
+    }
+    VM_CASE(GREATER): VM_COMPARISON(>)
+    VM_CASE(GREATER_EQUAL): VM_COMPARISON(>=)
+    VM_CASE(LESS): VM_COMPARISON(<)
+    VM_CASE(LESS_EQUAL): VM_COMPARISON(<=)
+    VM_CASE(ADD): VM_ARITHMETIC(+, "Operands must be double or string.")
+    VM_CASE(SUBTRACT): VM_ARITHMETIC(-, "Operands must be double.")
+    VM_CASE(MULTIPLY): VM_ARITHMETIC(*, "Operands must be double.")
+    VM_CASE(DIVIDE): VM_ARITHMETIC(/, "Operands must be double.")
+    VM_CASE(NOT): {
+        sp[-1] = Value{isFalsey(sp[-1])};
+        VM_NEXT();
+    }
+    VM_CASE(NEGATE): {
+        if (!sp[-1].isNumber()) VM_ERROR("Operand must be a number.");
+        sp[-1] = -sp[-1];
+        VM_NEXT();
+    }
+#undef VM_ARITHMETIC
+#undef VM_COMPARISON
+
+    VM_CASE(PRINT): {
+        Value value = std::move(*--sp);
+        if (value.isString()) {
+            // Straight from the shared characters, without a copy
+            auto text = value.asString();
+            std::cout.write(text.data(),text.size())<<std::endl;
+        } else {
+            std::cout<<Interpreter::stringify(value)<<std::endl;
+        }
+        VM_NEXT();
+    }
+
+    VM_CASE(JUMP): {
+        uint32_t distance = read32(ip);
+        ip += distance;
+        VM_NEXT();
+    }
+    VM_CASE(JUMP_IF_FALSE): {
+        uint32_t distance = read32(ip);
+        if (isFalsey(sp[-1])) ip += distance;
+        VM_NEXT();
+    }
+    VM_CASE(JUMP_IF_TRUE): {
+        uint32_t distance = read32(ip);
+        if (!isFalsey(sp[-1])) ip += distance;
+        VM_NEXT();
+    }
+    VM_CASE(POP_JUMP_IF_FALSE): {
+        uint32_t distance = read32(ip);
+        Value condition = std::move(*--sp);
+        if (isFalsey(condition)) ip += distance;
+        VM_NEXT();
+    }
+    VM_CASE(LOOP): {
+        uint32_t distance = read32(ip);
+        ip -= distance;
+        VM_NEXT();
+    }
+
+    // The callee sits below its arguments, which become the first slots of
+    // its frame. Whatever the call returns takes the callee's place.
+    VM_CASE(CALL): {
+        uint16_t argc = read16(ip);
+        Value* callee = sp - argc - 1;
+        if (!callee->isCallable()) VM_ERROR("Can only call functions and classes.");
+
+        LoxCallable* callable = callee->asCallable();
+        LoxFunction* function = callable->asFunction();
+        if (function == nullptr) {
+            // Natives read their arguments off the interpreter's stack
+            _top = sp;
+            Value result = _interpreter->call(callable, callee + 1, argc);
+            while (sp != callee + 1) *--sp = Value{};
+            *callee = std::move(result);
+            VM_NEXT();
+        }
+
+        Function* declaration = function->function();
+        if (declaration->code == nullptr) {
+            _top = sp;
+            compileLate(declaration);
+        }
+        Chunk* code = declaration->code;
+        Value* base = sp - argc;
+        if (_frameCount == MAX_FRAMES || base + code->frameSize + code->maxStack > stackEnd) {
+            VM_ERROR("Stack overflow.");
+        }
+
+        // Missing arguments are nil and extra ones are dropped, as the
+        // tree-walker's frames have exactly frameSize slots too
+        Value* frameEnd = base + code->frameSize;
+        while (sp < frameEnd) *sp++ = Value{};
+        while (sp > frameEnd) *--sp = Value{};
+
+        // Captured parameters move into cells of their own
+        size_t cellBase = _cells.size();
+        if (code->cells > 0) {
+            _cells.resize(cellBase + code->cells);
+            for (auto param : code->cellParams) {
+                _cells[cellBase + param] = std::make_shared<Cell>(Cell{base[param]});
+            }
+        }
+
+        frame->ip = ip;
+        frame = &_frames[_frameCount++];
+        *frame = CallFrame{nullptr, code, base, cellBase, &function->captures()};
+        chunk = code;
+        ip = code->code.data();
+        slots = base;
+        VM_NEXT();
+    }
+    VM_CASE(CLOSURE): {
+        Function* function = chunk->functions[read32(ip)];
+        *sp++ = Value{new LoxFunction{function, capture(function, *frame)}};
+        VM_NEXT();
+    }
+    VM_CASE(RETURN): {
+        Value result = std::move(*--sp);
+        while (sp != slots) *--sp = Value{};
+        if (chunk->cells > 0) _cells.resize(frame->cellBase);
+
+        // The top level returns nil once it has run through
+        if (--_frameCount == 0) {
+            _top = sp;
+            return;
+        }
+
+        // The callee below the frame goes as well
+        *--sp = std::move(result);
+        sp++;
+        frame = &_frames[_frameCount - 1];
+        chunk = frame->chunk;
+        ip = frame->ip;
+        slots = frame->slots;
+        VM_NEXT();
+    }
+    }
+
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_ERROR
+}
+
+// The cells a new closure of `function` keeps: only the ones it uses, taken
+// from the running frame or passed down from the running closure
+Upvalues VM::capture(Function* function, const CallFrame& frame) {
+    Upvalues upvalues{};
+    upvalues.reserve(function->upvalues.size());
+    for (auto& capture : function->upvalues) {
+        upvalues.push_back(capture.local ? _cells[frame.cellBase + capture.index] : (*frame.upvalues)[capture.index]);
+    }
+    return upvalues;
+}
+
+// A body deferred under --lazy, on its first call. compileDeferred forgets
+// which program the body came from, so its arena is looked up first.
+void VM::compileLate(Function* function) {
+    Arena& arena = function->deferred->program->arena;
+    Lox::compileDeferred(function);
+    Compiler compiler{};
+    compiler.compile(function, arena);
+}
+
+} // Lox namespace
@@ -1,4 +1,5 @@
 import argparse
+import re
 from typing import List
 
 def main(dir :str):
@@ -6,10 +7,28 @@ def main(dir :str):
         outputDir=dir,
         baseName= "Expr",
         types = [
-            "Binary   : std::shared_ptr<Expr> left, Token op, std::shared_ptr<Expr> right",
-            "Grouping : std::shared_ptr<Expr> expression",
-            "Literal  : std::variant<double,std::string,std::monostate> value",
-            "Unary    : Token op, std::shared_ptr<Expr> right"
+            "Binary   : Expr* left, TokenType op, int line, Expr* right",
+            "Grouping : Expr* expression",
+            "Unary    : TokenType op, int line, Expr* expression",
+            "Literal  : Value value",
+            "Variable : Token name",
+            "Assign   : Token name, Expr* value",
+            "Logical  : Expr* left, TokenType op, Expr* right",
+            "Call     : Expr* callee, int line, ArenaArray<Expr*> arguments"
+        ]
+    )
+    defineAst(
+        outputDir=dir,
+        baseName= "Stmt",
+        types = [
+            "Expression : Expr* expr",
+            "Function   : Token name, ArenaArray<Parameter> params, ArenaArray<Stmt*> body",
+            "Return     : int line, Expr* value",
+            "Var        : Token name, Expr* initializer",
+            "Print      : Expr* value",
+            "Block      : ArenaArray<Stmt*> statements",
+            "If         : Expr* condition, Stmt* thenBranch, Stmt* elseBranch",
+            "While      : Expr* expr, Stmt* body"
         ]
     )
 
@@ -21,49 +40,78 @@ def defineAst(outputDir : str, baseName : str, types : List[str]) -> None:
     cpp_write(path,baseName,types)
 
 
+def kindName(className : str) -> str:
+    """
+    Binary -> BINARY, the enumerator a class is tagged with
+    """
+    return re.sub(r"(?<!^)(?=[A-Z])", "_", className).upper()
+
+
+def splitFields(fieldList : str) -> List[str]:
+    """
+    Split on the commas between fields, not those inside template arguments
+    """
+    fields, depth, current = [], 0, ""
+    for c in fieldList:
+        if c == "," and depth == 0:
+            fields.append(current.strip())
+            current = ""
+            continue
+        depth += (c == "<") - (c == ">")
+        current += c
+    fields.append(current.strip())
+    return fields
+
+
 def defineType(file,baseName,className,fieldList):
     """
     Writes in the definitions for concrete types
     """
+    fields = splitFields(fieldList)
+    names = [field.split(" ")[-1] for field in fields]
+
     file.write(f"class {className} : public {baseName} {'{'}\n")
     file.write(f"public:\n")
 
-    file.write(f"\t{className}({fieldList}) {'{'}\n")
-    fields = fieldList.split(", ")
-    for field in fields:
-        name = field.split(" ")[1]
-        file.write(f"\t\t this->{name} = {name}; \n")
-    file.write(f"\t{'}'}\n")
-
-    # Desctructor override
-    file.write(f"\tvirtual ~{className}() override = default;\n\n")
-
-    # Visitor patter
-    templ = "T"
-    file.write(f"\ttemplate<typename {templ}>\n")
-    file.write(f"\t{templ} accept(std::shared_ptr<Visitor<{templ}>> visitor) {'{'}\n")
-    file.write(f"\t\treturn visitor.visit{className}{baseName}(this);\n")
-    file.write(f"\t{'}'}\n")
+    explicit = "explicit " if len(fields) == 1 else ""
+    file.write(f"    {explicit}{className}({', '.join(fields)})\n")
+    initializers = [f"{baseName}{'{'}{baseName}Kind::{kindName(className)}{'}'}"]
+    initializers += [f"{name}{'{'}{name}{'}'}" for name in names]
+    file.write(f"    : {', '.join(initializers)}\n")
+    file.write(f"    {'{}'}\n\n")
 
     # Field setup
     for field in fields:
-        file.write(f"\t{field};\n")
-
+        file.write(f"    {field};\n")
 
     file.write(f"{'}'};\n")
 
-def defineVisitor(file,baseName,types):
-    templ = "T"
-    file.write(f"template<typename {templ}>\n")
-    file.write(f"class Visitor {'{'}\n")
-    
-    for type in types:
-        typeName = type.split(":")[0].strip()
-        file.write(f"\tvirtual {templ} visit{typeName}{baseName}({typeName} {baseName.lower()}) = 0;\n")
-
-
+def defineKinds(file,baseName,types):
+    """
+    One enumerator per concrete type, what accept switches on
+    """
+    file.write(f"enum class {baseName}Kind : uint8_t {'{'}\n")
+    kinds = [kindName(type.split(":")[0].strip()) for type in types]
+    file.write(",\n".join(f"    {kind}" for kind in kinds))
+    file.write(f"\n{'}'};\n\n")
 
-    file.write(f"{'}'};\n\n")
+def defineDispatch(file,baseName,types):
+    """
+    A visitor is any class with a visit method per type, so accept calls
+    them directly instead of through a virtual interface
+    """
+    file.write("template<typename Visitor>\n")
+    file.write(f"auto {baseName}::accept(Visitor* visitor) {'{'}\n")
+    file.write("    switch (kind) {\n")
+    classNames = [type.split(":")[0].strip() for type in types]
+    for className in classNames[:-1]:
+        file.write(f"    case {baseName}Kind::{kindName(className)}: "
+                   f"return visitor->visit{className}{baseName}(static_cast<{className}*>(this));\n")
+    last = classNames[-1]
+    file.write(f"    case {baseName}Kind::{kindName(last)}: break;\n")
+    file.write("    }\n")
+    file.write(f"    return visitor->visit{last}{baseName}(static_cast<{last}*>(this));\n")
+    file.write(f"{'}'}\n\n")
 
 
 def hpp_write(path : str, baseName : str, types : List[str]) -> None:
@@ -73,42 +121,42 @@ def hpp_write(path : str, baseName : str, types : List[str]) -> None:
         f_hpp.write(f"#ifndef {baseName.upper()}_HPP\n")
         f_hpp.write(f"#define {baseName.upper()}_HPP\n\n")
 
-        f_hpp.write("#include \"token.hpp\"\n\n")
+        f_hpp.write("#include \"arena.hpp\"\n")
+        f_hpp.write("#include \"token.hpp\"\n")
+        f_hpp.write("#include \"value.hpp\"\n\n")
 
-        f_hpp.write("#include <list>\n")
-        f_hpp.write("#include <string>\n")
-        f_hpp.write("#include <variant>\n")
-        f_hpp.write("#include <memory>\n")
+        f_hpp.write("#include <cstdint>\n")
         f_hpp.write("\n")
 
         f_hpp.write("namespace Lox {\n\n")
-        
+
+        defineKinds(f_hpp,baseName,types)
+
         # Set up base class
-        f_hpp.write(f"class {baseName} {'{'}\n\n")
+        f_hpp.write(f"class {baseName} {'{'}\n")
         f_hpp.write("public:\n")
-        f_hpp.write(f"\t{baseName}() = default;\n")
-        f_hpp.write(f"\tvirtual ~{baseName}() = 0;\n\n")
-        
-        templ = "T"
-        f_hpp.write(f"\ttemplate<typename {templ}>\n")
-        f_hpp.write(f"\t{templ} accept(std::shared_ptr<Visitor<{templ}>> visitor) {'{'}\n")
-        f_hpp.write(f"\t{'}'}\n")
-
+        f_hpp.write(f"    ~{baseName}() = default;\n\n")
+        f_hpp.write("    template<typename Visitor>\n")
+        f_hpp.write("    auto accept(Visitor* visitor);\n\n")
+        f_hpp.write(f"    const {baseName}Kind kind;\n\n")
+        f_hpp.write("protected:\n")
+        f_hpp.write(f"    explicit {baseName}({baseName}Kind kind) : kind{'{'}kind{'}'}\n")
+        f_hpp.write(f"    {'{}'}\n")
         f_hpp.write("};\n\n")
 
-        # Generate each subclass of the Expr class
+        # Generate each subclass of the base class
         for type in types:
             className = type.split(" : ")[0].strip()
             fields = type.split(" : ")[1].strip()
             defineType(f_hpp, baseName, className, fields)
             f_hpp.write("\n")
 
-        # Define visitor(s)
-        defineVisitor(f_hpp,baseName,types)
+        # Dispatch on the kind
+        defineDispatch(f_hpp,baseName,types)
 
-        f_hpp.write("} // namespace Lox\n\n")
+        f_hpp.write("} // Lox namespace\n\n")
 
-        f_hpp.write("#endif")
+        f_hpp.write("#endif\n")
 
 def cpp_write(path : str, baseName : str, types : List[str]) -> None:
     cpp_path = path + ".cpp"
@@ -119,4 +167,4 @@ if __name__ == '__main__':
     parser.add_argument("--dir",type=str,default="generated",help="Directory to store generated files")
     args = parser.parse_args()
 
-    main(dir = args.dir)
\ No newline at end of file
+    main(dir = args.dir)
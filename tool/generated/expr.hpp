@@ -1,96 +1,136 @@
 #ifndef EXPR_HPP
 #define EXPR_HPP
 
+#include "arena.hpp"
 #include "token.hpp"
+#include "value.hpp"
 
-#include <list>
-#include <string>
-#include <variant>
-#include <memory>
+#include <cstdint>
 
 namespace Lox {
 
-class Expr {
+enum class ExprKind : uint8_t {
+    BINARY,
+    GROUPING,
+    UNARY,
+    LITERAL,
+    VARIABLE,
+    ASSIGN,
+    LOGICAL,
+    CALL
+};
 
+class Expr {
 public:
-	Expr() = default;
-	virtual ~Expr() = 0;
+    ~Expr() = default;
 
-	template<typename T>
-	T accept(std::shared_ptr<Visitor<T>> visitor) {
-	}
+    template<typename Visitor>
+    auto accept(Visitor* visitor);
+
+    const ExprKind kind;
+
+protected:
+    explicit Expr(ExprKind kind) : kind{kind}
+    {}
 };
 
 class Binary : public Expr {
 public:
-	Binary(std::shared_ptr<Expr> left, Token op, std::shared_ptr<Expr> right) {
-		 this->left = left; 
-		 this->op = op; 
-		 this->right = right; 
-	}
-	virtual ~Binary() override = default;
-
-	template<typename T>
-	T accept(std::shared_ptr<Visitor<T>> visitor) {
-		return visitor.visitBinaryExpr(this);
-	}
-	std::shared_ptr<Expr> left;
-	Token op;
-	std::shared_ptr<Expr> right;
+    Binary(Expr* left, TokenType op, int line, Expr* right)
+    : Expr{ExprKind::BINARY}, left{left}, op{op}, line{line}, right{right}
+    {}
+
+    Expr* left;
+    TokenType op;
+    int line;
+    Expr* right;
 };
 
 class Grouping : public Expr {
 public:
-	Grouping(std::shared_ptr<Expr> expression) {
-		 this->expression = expression; 
-	}
-	virtual ~Grouping() override = default;
-
-	template<typename T>
-	T accept(std::shared_ptr<Visitor<T>> visitor) {
-		return visitor.visitGroupingExpr(this);
-	}
-	std::shared_ptr<Expr> expression;
+    explicit Grouping(Expr* expression)
+    : Expr{ExprKind::GROUPING}, expression{expression}
+    {}
+
+    Expr* expression;
+};
+
+class Unary : public Expr {
+public:
+    Unary(TokenType op, int line, Expr* expression)
+    : Expr{ExprKind::UNARY}, op{op}, line{line}, expression{expression}
+    {}
+
+    TokenType op;
+    int line;
+    Expr* expression;
 };
 
 class Literal : public Expr {
 public:
-	Literal(std::variant<double,std::string,std::monostate> value) {
-		 this->value = value; 
-	}
-	virtual ~Literal() override = default;
-
-	template<typename T>
-	T accept(std::shared_ptr<Visitor<T>> visitor) {
-		return visitor.visitLiteralExpr(this);
-	}
-	std::variant<double,std::string,std::monostate> value;
+    explicit Literal(Value value)
+    : Expr{ExprKind::LITERAL}, value{value}
+    {}
+
+    Value value;
 };
 
-class Unary : public Expr {
+class Variable : public Expr {
 public:
-	Unary(Token op, std::shared_ptr<Expr> right) {
-		 this->op = op; 
-		 this->right = right; 
-	}
-	virtual ~Unary() override = default;
-
-	template<typename T>
-	T accept(std::shared_ptr<Visitor<T>> visitor) {
-		return visitor.visitUnaryExpr(this);
-	}
-	Token op;
-	std::shared_ptr<Expr> right;
+    explicit Variable(Token name)
+    : Expr{ExprKind::VARIABLE}, name{name}
+    {}
+
+    Token name;
 };
 
-template<typename T>
-class Visitor {
-	virtual T visitBinaryExpr(Binary expr) = 0;
-	virtual T visitGroupingExpr(Grouping expr) = 0;
-	virtual T visitLiteralExpr(Literal expr) = 0;
-	virtual T visitUnaryExpr(Unary expr) = 0;
+class Assign : public Expr {
+public:
+    Assign(Token name, Expr* value)
+    : Expr{ExprKind::ASSIGN}, name{name}, value{value}
+    {}
+
+    Token name;
+    Expr* value;
 };
 
-} // namespace Lox
+class Logical : public Expr {
+public:
+    Logical(Expr* left, TokenType op, Expr* right)
+    : Expr{ExprKind::LOGICAL}, left{left}, op{op}, right{right}
+    {}
+
+    Expr* left;
+    TokenType op;
+    Expr* right;
+};
+
+class Call : public Expr {
+public:
+    Call(Expr* callee, int line, ArenaArray<Expr*> arguments)
+    : Expr{ExprKind::CALL}, callee{callee}, line{line}, arguments{arguments}
+    {}
+
+    Expr* callee;
+    int line;
+    ArenaArray<Expr*> arguments;
+};
 
-#endif
\ No newline at end of file
+template<typename Visitor>
+auto Expr::accept(Visitor* visitor) {
+    switch (kind) {
+    case ExprKind::BINARY: return visitor->visitBinaryExpr(static_cast<Binary*>(this));
+    case ExprKind::GROUPING: return visitor->visitGroupingExpr(static_cast<Grouping*>(this));
+    case ExprKind::UNARY: return visitor->visitUnaryExpr(static_cast<Unary*>(this));
+    case ExprKind::LITERAL: return visitor->visitLiteralExpr(static_cast<Literal*>(this));
+    case ExprKind::VARIABLE: return visitor->visitVariableExpr(static_cast<Variable*>(this));
+    case ExprKind::ASSIGN: return visitor->visitAssignExpr(static_cast<Assign*>(this));
+    case ExprKind::LOGICAL: return visitor->visitLogicalExpr(static_cast<Logical*>(this));
+    case ExprKind::CALL: break;
+    }
+    return visitor->visitCallExpr(static_cast<Call*>(this));
+}
+
+} // Lox namespace
+
+#endif
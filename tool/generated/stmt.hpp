@@ -0,0 +1,133 @@
+#ifndef STMT_HPP
+#define STMT_HPP
+
+#include "arena.hpp"
+#include "token.hpp"
+#include "value.hpp"
+
+#include <cstdint>
+
+namespace Lox {
+
+enum class StmtKind : uint8_t {
+    EXPRESSION,
+    FUNCTION,
+    RETURN,
+    VAR,
+    PRINT,
+    BLOCK,
+    IF,
+    WHILE
+};
+
+class Stmt {
+public:
+    ~Stmt() = default;
+
+    template<typename Visitor>
+    auto accept(Visitor* visitor);
+
+    const StmtKind kind;
+
+protected:
+    explicit Stmt(StmtKind kind) : kind{kind}
+    {}
+};
+
+class Expression : public Stmt {
+public:
+    explicit Expression(Expr* expr)
+    : Stmt{StmtKind::EXPRESSION}, expr{expr}
+    {}
+
+    Expr* expr;
+};
+
+class Function : public Stmt {
+public:
+    Function(Token name, ArenaArray<Parameter> params, ArenaArray<Stmt*> body)
+    : Stmt{StmtKind::FUNCTION}, name{name}, params{params}, body{body}
+    {}
+
+    Token name;
+    ArenaArray<Parameter> params;
+    ArenaArray<Stmt*> body;
+};
+
+class Return : public Stmt {
+public:
+    Return(int line, Expr* value)
+    : Stmt{StmtKind::RETURN}, line{line}, value{value}
+    {}
+
+    int line;
+    Expr* value;
+};
+
+class Var : public Stmt {
+public:
+    Var(Token name, Expr* initializer)
+    : Stmt{StmtKind::VAR}, name{name}, initializer{initializer}
+    {}
+
+    Token name;
+    Expr* initializer;
+};
+
+class Print : public Stmt {
+public:
+    explicit Print(Expr* value)
+    : Stmt{StmtKind::PRINT}, value{value}
+    {}
+
+    Expr* value;
+};
+
+class Block : public Stmt {
+public:
+    explicit Block(ArenaArray<Stmt*> statements)
+    : Stmt{StmtKind::BLOCK}, statements{statements}
+    {}
+
+    ArenaArray<Stmt*> statements;
+};
+
+class If : public Stmt {
+public:
+    If(Expr* condition, Stmt* thenBranch, Stmt* elseBranch)
+    : Stmt{StmtKind::IF}, condition{condition}, thenBranch{thenBranch}, elseBranch{elseBranch}
+    {}
+
+    Expr* condition;
+    Stmt* thenBranch;
+    Stmt* elseBranch;
+};
+
+class While : public Stmt {
+public:
+    While(Expr* expr, Stmt* body)
+    : Stmt{StmtKind::WHILE}, expr{expr}, body{body}
+    {}
+
+    Expr* expr;
+    Stmt* body;
+};
+
+template<typename Visitor>
+auto Stmt::accept(Visitor* visitor) {
+    switch (kind) {
+    case StmtKind::EXPRESSION: return visitor->visitExpressionStmt(static_cast<Expression*>(this));
+    case StmtKind::FUNCTION: return visitor->visitFunctionStmt(static_cast<Function*>(this));
+    case StmtKind::RETURN: return visitor->visitReturnStmt(static_cast<Return*>(this));
+    case StmtKind::VAR: return visitor->visitVarStmt(static_cast<Var*>(this));
+    case StmtKind::PRINT: return visitor->visitPrintStmt(static_cast<Print*>(this));
+    case StmtKind::BLOCK: return visitor->visitBlockStmt(static_cast<Block*>(this));
+    case StmtKind::IF: return visitor->visitIfStmt(static_cast<If*>(this));
+    case StmtKind::WHILE: break;
+    }
+    return visitor->visitWhileStmt(static_cast<While*>(this));
+}
+
+} // Lox namespace
+
+#endif